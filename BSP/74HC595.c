@@ -2,6 +2,11 @@
 
 #include "74HC595.h"
 
+/* 输出映像、修改序号和已输出的序号(两者不等即映像待输出) */
+static volatile uint32_t s_hc595_image = 0;
+static volatile uint32_t s_hc595_seq = 0;
+static volatile uint32_t s_hc595_flushed = 0;
+
 /**
   * @brief  初始化74HC595相关的IO口
   * @param  无
@@ -26,6 +31,9 @@ void HC595_Init(void)
   HAL_GPIO_WritePin(HC595_GPIO_PORT, ST_CP_PIN, GPIO_PIN_RESET);
   HAL_GPIO_WritePin(HC595_GPIO_PORT, SH_CP_PIN, GPIO_PIN_RESET);
 
+  s_hc595_image = 0;
+  s_hc595_seq = 0;
+  s_hc595_flushed = 0;
   HC595_Send24Bits(0x000000);
 }
 
@@ -39,27 +47,112 @@ void HC595_Send24Bits(uint32_t data)
   uint8_t i;
   
   /* 禁止输出 */
-  HAL_GPIO_WritePin(HC595_GPIO_PORT, ST_CP_PIN, GPIO_PIN_RESET);
+  HC595_GPIO_PORT->BRR = ST_CP_PIN;
   
-  /* 移位发送24位数据(从高位到低位) */
+  /* 移位发送24位数据(从高位到低位)，直接写BSRR/BRR */
   for (i = 0; i < 24; i++)
   {
     /* 设置数据位 */
     if (data & 0x800000)
-      HAL_GPIO_WritePin(HC595_GPIO_PORT, SER_IN_PIN, GPIO_PIN_SET);
+      HC595_GPIO_PORT->BSRR = SER_IN_PIN;
     else
-      HAL_GPIO_WritePin(HC595_GPIO_PORT, SER_IN_PIN, GPIO_PIN_RESET);
+      HC595_GPIO_PORT->BRR = SER_IN_PIN;
     
-    //
     /* 产生移位时钟上升沿 */
-    HAL_GPIO_WritePin(HC595_GPIO_PORT, SH_CP_PIN, GPIO_PIN_RESET);
-    HAL_GPIO_WritePin(HC595_GPIO_PORT, SH_CP_PIN, GPIO_PIN_SET);
+    HC595_GPIO_PORT->BRR = SH_CP_PIN;
+    HC595_GPIO_PORT->BSRR = SH_CP_PIN;
     
     /* 数据左移一位 */
     data <<= 1;
   }
   
   /* 产生存储时钟上升沿，将数据锁存到输出寄存器 */
-  HAL_GPIO_WritePin(HC595_GPIO_PORT, ST_CP_PIN, GPIO_PIN_RESET);
-  HAL_GPIO_WritePin(HC595_GPIO_PORT, ST_CP_PIN, GPIO_PIN_SET);
+  HC595_GPIO_PORT->BRR = ST_CP_PIN;
+  HC595_GPIO_PORT->BSRR = ST_CP_PIN;
+}
+
+/**
+  * @brief  修改输出映像中的位(不移位输出)
+  * @param  mask: 要修改的位
+  * @param  value: 新的值(只取mask中的位)
+  * @retval 本次修改后的映像序号
+  */
+uint32_t HC595_WriteBits(uint32_t mask, uint32_t value)
+{
+  uint32_t primask = __get_PRIMASK();
+  uint32_t image;
+  uint32_t seq;
+  
+  __disable_irq();
+  image = (s_hc595_image & ~mask) | (value & mask);
+  if (image != s_hc595_image)
+  {
+    s_hc595_image = image;
+    s_hc595_seq++;
+  }
+  seq = s_hc595_seq;
+  __set_PRIMASK(primask);
+  
+  return seq;
+}
+
+/**
+  * @brief  输出映像中的位置1
+  * @param  mask: 要置1的位
+  * @retval 本次修改后的映像序号
+  */
+uint32_t HC595_SetBits(uint32_t mask)
+{
+  return HC595_WriteBits(mask, mask);
+}
+
+/**
+  * @brief  输出映像中的位清0
+  * @param  mask: 要清0的位
+  * @retval 本次修改后的映像序号
+  */
+uint32_t HC595_ClearBits(uint32_t mask)
+{
+  return HC595_WriteBits(mask, 0);
+}
+
+/**
+  * @brief  读取输出映像
+  * @retval 当前映像(可能还未输出)
+  */
+uint32_t HC595_GetImage(void)
+{
+  return s_hc595_image;
+}
+
+/**
+  * @brief  映像有修改时移位输出(主循环中调用)
+  * @param  seq: 返回本次输出的映像序号(可为NULL)
+  * @retval 1 已输出  0 映像无修改
+  * @note   移位期间中断中的修改计入下一次输出
+  */
+uint8_t HC595_Flush(uint32_t *seq)
+{
+  uint32_t primask = __get_PRIMASK();
+  uint32_t image;
+  uint32_t snap;
+  
+  __disable_irq();
+  if (s_hc595_flushed == s_hc595_seq)
+  {
+    __set_PRIMASK(primask);
+    return 0;
+  }
+  image = s_hc595_image;
+  snap = s_hc595_seq;
+  __set_PRIMASK(primask);
+  
+  HC595_Send24Bits(image);
+  s_hc595_flushed = snap;
+  
+  if (seq != NULL)
+  {
+    *seq = snap;
+  }
+  return 1;
 }
\ No newline at end of file
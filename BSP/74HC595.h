@@ -13,4 +13,15 @@
 void HC595_Init(void);
 void HC595_Send24Bits(uint32_t data);
 
+/*
+ * 输出映像: 各模块只修改映像(可在中断中调用)，主循环调用HC595_Flush统一移位输出，
+ * 同一轮循环中的多次修改只移位一次。每次修改映像序号加1，HC595_Flush返回已输出的序号，
+ * 调用者据此判断某次修改是否已经到达引脚
+ */
+uint32_t HC595_SetBits(uint32_t mask);
+uint32_t HC595_ClearBits(uint32_t mask);
+uint32_t HC595_WriteBits(uint32_t mask, uint32_t value);
+uint32_t HC595_GetImage(void);
+uint8_t HC595_Flush(uint32_t *seq);
+
 #endif // !__74HC595_H
\ No newline at end of file
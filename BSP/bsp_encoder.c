@@ -0,0 +1,67 @@
+/**
+ * @file bsp_encoder.c
+ * @brief 编码器输入模块实现文件
+ * @note 定时器工作在编码器模式，计数器随A/B相正交信号加减，步进电机模块按步读取计数器，
+ *       16位计数器的回绕由读取方按增量处理
+ */
+
+#include "bsp_encoder.h"
+
+static TIM_HandleTypeDef s_encoder_tim;
+
+/**
+ * @brief 读编码器计数器
+ */
+static uint16_t Encoder_Read(StepperMotor_t* motor)
+{
+    (void)motor;
+    return (uint16_t)ENCODER_TIM->CNT;
+}
+
+/**
+ * @brief 初始化编码器输入并挂接到电机
+ */
+void bsp_InitEncoder(StepperMotor_t* motor, GPIO_TypeDef* port, uint16_t pins, uint8_t af,
+                     int32_t steps_per_count, uint16_t window, uint16_t stall)
+{
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+    TIM_Encoder_InitTypeDef EncoderConfig = {0};
+
+    ENCODER_TIM_CLK_ENABLE();
+
+    /* 编码器多为集电极开路输出，内部上拉 */
+    GPIO_InitStruct.Pin = pins;
+    GPIO_InitStruct.Mode = GPIO_MODE_AF_PP;
+    GPIO_InitStruct.Pull = GPIO_PULLUP;
+    GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_HIGH;
+    GPIO_InitStruct.Alternate = af;
+    HAL_GPIO_Init(port, &GPIO_InitStruct);
+
+    /* 计数器不分频，在0~0xFFFF之间回绕 */
+    s_encoder_tim.Instance = ENCODER_TIM;
+    s_encoder_tim.Init.Prescaler         = 0;
+    s_encoder_tim.Init.Period            = 0xFFFF;
+    s_encoder_tim.Init.ClockDivision     = 0;
+    s_encoder_tim.Init.CounterMode       = TIM_COUNTERMODE_UP;
+    s_encoder_tim.Init.RepetitionCounter = 0;
+    s_encoder_tim.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_DISABLE;
+
+    /* 两相的上下沿都计数(四倍频) */
+    EncoderConfig.EncoderMode  = TIM_ENCODERMODE_TI12;
+    EncoderConfig.IC1Polarity  = TIM_ICPOLARITY_RISING;
+    EncoderConfig.IC1Selection = TIM_ICSELECTION_DIRECTTI;
+    EncoderConfig.IC1Prescaler = TIM_ICPSC_DIV1;
+    EncoderConfig.IC1Filter    = ENCODER_FILTER;
+    EncoderConfig.IC2Polarity  = TIM_ICPOLARITY_RISING;
+    EncoderConfig.IC2Selection = TIM_ICSELECTION_DIRECTTI;
+    EncoderConfig.IC2Prescaler = TIM_ICPSC_DIV1;
+    EncoderConfig.IC2Filter    = ENCODER_FILTER;
+
+    if (HAL_TIM_Encoder_Init(&s_encoder_tim, &EncoderConfig) != HAL_OK) {
+        printf("Encoder timer init error\r\n");
+        return;
+    }
+    HAL_TIM_Encoder_Start(&s_encoder_tim, TIM_CHANNEL_ALL);
+
+    Stepper_AttachEncoder(motor, Encoder_Read, steps_per_count, window, stall);
+}
@@ -0,0 +1,34 @@
+/**
+ * @file bsp_encoder.h
+ * @brief 编码器输入模块头文件(定时器编码器模式，供步进电机闭环使用)
+ */
+
+#ifndef __BSP_ENCODER_H
+#define __BSP_ENCODER_H
+
+#include "bsp_motor.h"
+
+// 编码器定时器: 只有TIM1和TIM3支持编码器模式，TIM3为系统时基，只能使用TIM1。
+// TIM1同时是步进脉冲引擎的比较定时器，使用编码器时不调用Stepper_TimerInit，
+// 所有电机由DMA脉冲序列(或轮询方式)输出
+#define ENCODER_TIM                 TIM1
+#define ENCODER_TIM_CLK_ENABLE()    __HAL_RCC_TIM1_CLK_ENABLE()
+#define ENCODER_FILTER              4       // 输入滤波(0~15)，滤除A/B线上的毛刺
+
+/**
+ * @brief 初始化编码器输入并挂接到电机
+ * @param motor 步进电机结构体指针
+ * @param port A/B相引脚端口
+ * @param pins A/B相引脚(ENCODER_TIM通道1和通道2，GPIO_PIN_x | GPIO_PIN_y)
+ * @param af 引脚复用为ENCODER_TIM通道的复用功能号
+ * @param steps_per_count 每个编码器计数的步数(Q16.16，负数为计数方向与正转相反)
+ * @param window 跟随误差超过此步数时补步
+ * @param stall 跟随误差超过此步数时判为堵转
+ * @return 无
+ * @note 四倍频计数(A/B两相的上下沿都计数)，例如1000线编码器每转4000个计数，
+ *       200步/转、16细分时每计数0.8步(steps_per_count为52429)
+ */
+void bsp_InitEncoder(StepperMotor_t* motor, GPIO_TypeDef* port, uint16_t pins, uint8_t af,
+                     int32_t steps_per_count, uint16_t window, uint16_t stall);
+
+#endif // !__BSP_ENCODER_H
@@ -0,0 +1,215 @@
+/**
+ * @file bsp_home.c
+ * @brief 多阶段回原点
+ * @note 每个阶段都是一次普通的相对运动，由限位(中断或74HC165轮询)在开关处
+ *       停止并把位置清零；主循环轮询到电机空闲后根据限位状态进入下一阶段
+ */
+
+#include "bsp_home.h"
+
+// 不限制行程时寻找开关的步数
+#define HOMING_UNLIMITED_TRAVEL     0x7FFFFFFFUL
+
+// 私有函数声明
+static void Homing_Finish(Homing_t* homing, HomingState_t state, HomingError_t error);
+static void Homing_Backoff(Homing_t* homing);
+static uint32_t Homing_StartSpeed(const Homing_t* homing);
+static void Homing_Rebase(StepperMotor_t* motor, uint32_t position);
+
+/**
+ * @brief 初始化回原点过程
+ */
+void Homing_Init(Homing_t* homing, StepperMotor_t* motor)
+{
+    homing->motor = motor;
+    homing->state = HOMING_IDLE;
+    homing->error = HOMING_ERR_NONE;
+    homing->deviation = 0;
+    homing->seek_tripped = 0;
+    homing->restore_pending = 0;
+}
+
+/**
+ * @brief 开始回原点
+ */
+uint8_t Homing_Start(Homing_t* homing, const HomingConfig_t* config)
+{
+    StepperMotor_t* motor = homing->motor;
+    uint32_t travel;
+    uint32_t latch;
+
+    if (motor == NULL || config->fast_speed == 0 || config->slow_speed == 0 ||
+        config->backoff == 0 || motor->state != STEPPER_STATE_IDLE) {
+        return 0;
+    }
+
+    // 上次中断后还没恢复的速度参数先恢复，再作为本次的原参数保存
+    if (homing->restore_pending) {
+        homing->restore_pending = 0;
+        Stepper_RestoreSpeed(motor, &homing->saved_speed);
+    }
+
+    homing->config = *config;
+    homing->error = HOMING_ERR_NONE;
+    homing->deviation = 0;
+    homing->seek_tripped = 0;
+    Stepper_GetSpeed(motor, &homing->saved_speed);
+
+    Stepper_EnableLimitSwitches(motor, 1);
+    (void)Stepper_GetLatch(motor, &latch);  // 丢弃之前的锁存
+
+    // 已经在开关上时不能再朝开关运动，直接退离
+    if (motor->ccw_limit) {
+        Stepper_ResetPosition(motor);
+        Homing_Backoff(homing);
+        return 1;
+    }
+
+    homing->state = HOMING_SEEK;
+    travel = config->max_travel ? config->max_travel : HOMING_UNLIMITED_TRAVEL;
+    Homing_Rebase(motor, travel);
+    Stepper_SetSpeed(motor, config->fast_speed, Homing_StartSpeed(homing), config->accel);
+    Stepper_Move(motor, travel, STEPPER_DIR_CCW);
+    return 1;
+}
+
+/**
+ * @brief 回原点轮询
+ */
+void Homing_Poll(Homing_t* homing)
+{
+    StepperMotor_t* motor = homing->motor;
+    uint32_t latch;
+
+    if (motor->state != STEPPER_STATE_IDLE) {
+        return;
+    }
+
+    if (homing->restore_pending) {
+        homing->restore_pending = 0;
+        Stepper_RestoreSpeed(motor, &homing->saved_speed);
+    }
+
+    switch (homing->state) {
+    case HOMING_SEEK:
+        // 限位停止时位置已清零；没有触发说明走完了行程
+        if (!motor->ccw_limit) {
+            Homing_Finish(homing, HOMING_ERROR, HOMING_ERR_NOT_FOUND);
+            break;
+        }
+        (void)Stepper_GetLatch(motor, &latch);
+        homing->seek_tripped = 1;
+        Homing_Backoff(homing);
+        break;
+
+    case HOMING_BACKOFF:
+        if (motor->ccw_limit) {
+            Homing_Finish(homing, HOMING_ERROR, HOMING_ERR_NOT_RELEASED);
+            break;
+        }
+        // 以锁存速度直接启停，触发点不受加减速影响；
+        // 快速触发点在重新设定的坐标中位于backoff处
+        homing->state = HOMING_LATCH;
+        Homing_Rebase(motor, homing->config.backoff * 2);
+        Stepper_SetSpeed(motor, homing->config.slow_speed, homing->config.slow_speed, 0);
+        Stepper_Move(motor, homing->config.backoff * 2, STEPPER_DIR_CCW);
+        break;
+
+    case HOMING_LATCH:
+        if (!motor->ccw_limit) {
+            Homing_Finish(homing, HOMING_ERROR, HOMING_ERR_NOT_FOUND);
+            break;
+        }
+        // 两次触发点的偏差，正值表示慢速触发点在正转方向
+        if (Stepper_GetLatch(motor, &latch) && homing->seek_tripped) {
+            homing->deviation = (int32_t)(latch - homing->config.backoff);
+        }
+        if (homing->config.offset == 0) {
+            Homing_Finish(homing, HOMING_DONE, HOMING_ERR_NONE);
+            break;
+        }
+        homing->state = HOMING_OFFSET;
+        Stepper_SetSpeed(motor, homing->config.fast_speed, Homing_StartSpeed(homing), homing->config.accel);
+        Stepper_Move(motor, homing->config.offset, STEPPER_DIR_CW);
+        break;
+
+    case HOMING_OFFSET:
+        Stepper_ResetPosition(motor);
+        Homing_Finish(homing, HOMING_DONE, HOMING_ERR_NONE);
+        break;
+
+    default:
+        break;
+    }
+}
+
+/**
+ * @brief 中断回原点
+ */
+void Homing_Abort(Homing_t* homing, uint8_t immediate)
+{
+    if (!Homing_IsBusy(homing)) {
+        return;
+    }
+
+    // 减速停止时速度参数在电机停止后恢复
+    Stepper_Stop(homing->motor, immediate);
+    Homing_Finish(homing, HOMING_ERROR, HOMING_ERR_ABORTED);
+}
+
+/**
+ * @brief 是否正在回原点
+ */
+uint8_t Homing_IsBusy(const Homing_t* homing)
+{
+    return (homing->state >= HOMING_SEEK && homing->state <= HOMING_OFFSET) ? 1 : 0;
+}
+
+/**
+ * @brief 结束回原点并恢复速度参数
+ * @note 运行中修改速度参数会改变正在执行的加减速，电机未停止时推迟到轮询中恢复
+ */
+static void Homing_Finish(Homing_t* homing, HomingState_t state, HomingError_t error)
+{
+    homing->state = state;
+    homing->error = error;
+    if (homing->motor->state == STEPPER_STATE_IDLE) {
+        Stepper_RestoreSpeed(homing->motor, &homing->saved_speed);
+    } else {
+        homing->restore_pending = 1;
+    }
+}
+
+/**
+ * @brief 退离原点开关
+ */
+static void Homing_Backoff(Homing_t* homing)
+{
+    StepperMotor_t* motor = homing->motor;
+
+    homing->state = HOMING_BACKOFF;
+    Stepper_SetSpeed(motor, homing->config.fast_speed, Homing_StartSpeed(homing), homing->config.accel);
+    Stepper_Move(motor, homing->config.backoff, STEPPER_DIR_CW);
+}
+
+/**
+ * @brief 快速阶段的启动速度(不超过寻找速度)
+ */
+static uint32_t Homing_StartSpeed(const Homing_t* homing)
+{
+    return (homing->saved_speed.start_speed < homing->config.fast_speed) ?
+           homing->saved_speed.start_speed : homing->config.fast_speed;
+}
+
+/**
+ * @brief 重新设定空闲电机的位置计数
+ * @note 反转运动到位置0即结束，朝开关运动前把起点设为最大行程，使行程内不会先到达0
+ */
+static void Homing_Rebase(StepperMotor_t* motor, uint32_t position)
+{
+    motor->position = position;
+    motor->target_position = position;
+    motor->backlash_pending = 0;    // 回原点后位置重新计数，清除补偿步数
+    motor->backlash_offset = 0;
+    Stepper_EncoderSync(motor);
+}
@@ -0,0 +1,93 @@
+/**
+ * @file bsp_home.h
+ * @brief 多阶段回原点头文件
+ */
+
+#ifndef __BSP_HOME_H
+#define __BSP_HOME_H
+
+#include "bsp_motor.h"
+
+// 回原点阶段
+typedef enum {
+    HOMING_IDLE = 0,        // 未回原点
+    HOMING_SEEK,            // 快速寻找原点开关
+    HOMING_BACKOFF,         // 退离原点开关
+    HOMING_LATCH,           // 慢速再次接近，锁存原点
+    HOMING_OFFSET,          // 移动原点偏移
+    HOMING_DONE,            // 完成
+    HOMING_ERROR            // 失败(见error)
+} HomingState_t;
+
+// 回原点失败原因
+typedef enum {
+    HOMING_ERR_NONE = 0,
+    HOMING_ERR_NOT_FOUND,   // 行程内没有找到原点开关
+    HOMING_ERR_NOT_RELEASED,// 退离后原点开关仍然触发
+    HOMING_ERR_ABORTED      // 被停止命令中断
+} HomingError_t;
+
+// 回原点参数(原点开关为反转限位)
+typedef struct {
+    uint32_t fast_speed;    // 寻找开关速度(步/秒)
+    uint32_t slow_speed;    // 锁存速度(步/秒)，直接启停
+    uint32_t accel;         // 寻找和退离的加速度(步/秒^2)
+    uint32_t backoff;       // 退离步数，慢速接近的最大行程为其2倍
+    uint32_t offset;        // 原点偏移: 锁存点向正转方向移动的步数，移动后位置清零
+    uint32_t max_travel;    // 寻找开关的最大行程(步)，0表示不限制
+} HomingConfig_t;
+
+// 回原点过程
+typedef struct {
+    StepperMotor_t* motor;          // 电机
+    HomingConfig_t config;          // 本次回原点参数
+    volatile HomingState_t state;   // 当前阶段
+    HomingError_t error;            // 失败原因
+    int32_t deviation;              // 慢速与快速触发点的偏差(步)，快速寻找触发且中断锁存时有效
+    uint8_t seek_tripped;           // 快速寻找阶段触发了开关(开始时已在开关上为0)
+    StepperSpeed_t saved_speed;     // 回原点前的速度参数，结束后原样恢复(保留小数速度)
+    uint8_t restore_pending;        // 电机停止后再恢复速度参数
+} Homing_t;
+
+/**
+ * @brief 初始化回原点过程
+ * @param homing 回原点过程指针
+ * @param motor 电机指针(应已初始化)
+ * @return None
+ */
+void Homing_Init(Homing_t* homing, StepperMotor_t* motor);
+
+/**
+ * @brief 开始回原点(不阻塞)
+ * @param homing 回原点过程指针
+ * @param config 回原点参数
+ * @return 1 已开始  0 电机正在运行或参数无效
+ * @note 快速寻找反转限位 -> 退离 -> 慢速接近锁存 -> 移动偏移后位置清零。
+ *       开始时已在开关上则直接退离。会使能电机的限位功能
+ */
+uint8_t Homing_Start(Homing_t* homing, const HomingConfig_t* config);
+
+/**
+ * @brief 回原点轮询(在主循环中调用)
+ * @param homing 回原点过程指针
+ * @return None
+ * @note 电机停止后检查限位状态并启动下一阶段，多个电机可以同时回原点
+ */
+void Homing_Poll(Homing_t* homing);
+
+/**
+ * @brief 中断回原点
+ * @param homing 回原点过程指针
+ * @param immediate 1 立即停止  0 减速停止
+ * @return None
+ */
+void Homing_Abort(Homing_t* homing, uint8_t immediate);
+
+/**
+ * @brief 是否正在回原点
+ * @param homing 回原点过程指针
+ * @return 1 正在回原点  0 空闲/完成/失败
+ */
+uint8_t Homing_IsBusy(const Homing_t* homing);
+
+#endif // !__BSP_HOME_H
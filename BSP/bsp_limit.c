@@ -0,0 +1,126 @@
+/**
+ * @file bsp_limit.c
+ * @brief 限位/原点开关中断输入模块实现文件
+ * @note 通过HAL EXTI驱动配置上下沿中断，开关状态变化时直接通知电机，
+ *       不经过74HC165轮询，停止延迟不超过一步
+ */
+
+#include "bsp_limit.h"
+
+static const LimitInput_t* s_limit_inputs = NULL;
+static uint8_t s_limit_count = 0;
+static EXTI_HandleTypeDef s_limit_exti[LIMIT_MAX_INPUTS];
+
+static const uint32_t s_limit_lines[16] = {
+    EXTI_LINE_0,  EXTI_LINE_1,  EXTI_LINE_2,  EXTI_LINE_3,
+    EXTI_LINE_4,  EXTI_LINE_5,  EXTI_LINE_6,  EXTI_LINE_7,
+    EXTI_LINE_8,  EXTI_LINE_9,  EXTI_LINE_10, EXTI_LINE_11,
+    EXTI_LINE_12, EXTI_LINE_13, EXTI_LINE_14, EXTI_LINE_15
+};
+
+/**
+ * @brief 引脚掩码转换为引脚号
+ */
+static uint8_t Limit_PinIndex(uint16_t pin)
+{
+    uint8_t index = 0;
+
+    while (index < 15 && !(pin & (1U << index))) {
+        index++;
+    }
+    return index;
+}
+
+/**
+ * @brief 初始化限位输入
+ */
+void bsp_InitLimit(const LimitInput_t* inputs, uint8_t count)
+{
+    GPIO_InitTypeDef GPIO_InitStruct = {0};
+    EXTI_ConfigTypeDef ExtiConfig = {0};
+
+    if (count > LIMIT_MAX_INPUTS) {
+        count = LIMIT_MAX_INPUTS;
+    }
+    s_limit_inputs = inputs;
+    s_limit_count = 0;
+
+    for (uint8_t i = 0; i < count; i++) {
+        const LimitInput_t* input = &inputs[i];
+        uint8_t line = Limit_PinIndex(input->pin);
+        IRQn_Type irq;
+
+        if (input->port == GPIOA) {
+            __HAL_RCC_GPIOA_CLK_ENABLE();
+            ExtiConfig.GPIOSel = EXTI_GPIOA;
+        } else if (input->port == GPIOB) {
+            __HAL_RCC_GPIOB_CLK_ENABLE();
+            ExtiConfig.GPIOSel = EXTI_GPIOB;
+        } else {
+            __HAL_RCC_GPIOF_CLK_ENABLE();
+            ExtiConfig.GPIOSel = EXTI_GPIOF;
+        }
+
+        /* 开关未接时保持释放状态 */
+        GPIO_InitStruct.Pin = input->pin;
+        GPIO_InitStruct.Mode = GPIO_MODE_INPUT;
+        GPIO_InitStruct.Pull = input->active_level ? GPIO_PULLDOWN : GPIO_PULLUP;
+        GPIO_InitStruct.Speed = GPIO_SPEED_FREQ_LOW;
+        HAL_GPIO_Init(input->port, &GPIO_InitStruct);
+
+        ExtiConfig.Line = s_limit_lines[line];
+        ExtiConfig.Mode = EXTI_MODE_INTERRUPT;
+        ExtiConfig.Trigger = EXTI_TRIGGER_RISING_FALLING;
+        HAL_EXTI_SetConfigLine(&s_limit_exti[i], &ExtiConfig);
+        HAL_EXTI_ClearPending(&s_limit_exti[i]);
+
+        irq = (line <= 1) ? EXTI0_1_IRQn : (line <= 3) ? EXTI2_3_IRQn : EXTI4_15_IRQn;
+        HAL_NVIC_SetPriority(irq, LIMIT_IRQ_PRIORITY, 0);
+        HAL_NVIC_EnableIRQ(irq);
+    }
+    s_limit_count = count;
+
+    /* 同步上电时的开关状态 */
+    for (uint8_t i = 0; i < count; i++) {
+        Stepper_LimitEvent(inputs[i].motor, inputs[i].side, Limit_Read(i));
+    }
+}
+
+/**
+ * @brief 读取限位输入状态
+ */
+uint8_t Limit_Read(uint8_t index)
+{
+    const LimitInput_t* input = &s_limit_inputs[index];
+    uint8_t level = (HAL_GPIO_ReadPin(input->port, input->pin) == GPIO_PIN_SET) ? 1 : 0;
+
+    return (level == input->active_level) ? 1 : 0;
+}
+
+/**
+ * @brief 限位中断处理: 按挂起标志找到变化的输入，读取当前电平通知电机
+ */
+static void Limit_IRQHandler(void)
+{
+    for (uint8_t i = 0; i < s_limit_count; i++) {
+        if (HAL_EXTI_GetPending(&s_limit_exti[i], EXTI_TRIGGER_RISING_FALLING)) {
+            HAL_EXTI_ClearPending(&s_limit_exti[i]);
+            Stepper_LimitEvent(s_limit_inputs[i].motor, s_limit_inputs[i].side, Limit_Read(i));
+        }
+    }
+}
+
+void EXTI0_1_IRQHandler(void)
+{
+    Limit_IRQHandler();
+}
+
+void EXTI2_3_IRQHandler(void)
+{
+    Limit_IRQHandler();
+}
+
+void EXTI4_15_IRQHandler(void)
+{
+    Limit_IRQHandler();
+}
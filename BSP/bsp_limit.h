@@ -0,0 +1,44 @@
+/**
+ * @file bsp_limit.h
+ * @brief 限位/原点开关中断输入模块头文件
+ */
+
+#ifndef __BSP_LIMIT_H
+#define __BSP_LIMIT_H
+
+#include "bsp_motor.h"
+#include "bsp_step_dma.h"
+
+// 最多限位输入数(每个EXTI线只能选一个端口，不同输入的引脚号不能相同)
+#define LIMIT_MAX_INPUTS            8
+
+// 限位中断优先级: 与DMA脉冲序列填充中断相同，撤销缓冲区中的边沿时不会打断填充
+#define LIMIT_IRQ_PRIORITY          STEP_DMA_IRQ_PRIORITY
+
+// 限位输入
+typedef struct {
+    GPIO_TypeDef* port;         // 输入端口(GPIOA/GPIOB/GPIOF)
+    uint16_t pin;               // 输入引脚(GPIO_PIN_x)
+    uint8_t active_level;       // 触发电平: 0 低电平(开关接地，内部上拉)  1 高电平(内部下拉)
+    StepperMotor_t* motor;      // 所属电机
+    StepperDirection_t side;    // 限位所在方向(反转方向的限位同时作为原点)
+} LimitInput_t;
+
+/**
+ * @brief 初始化限位输入(上下沿都产生EXTI中断)
+ * @param inputs 限位输入表(应为常量，初始化后继续使用)
+ * @param count 输入数(不超过LIMIT_MAX_INPUTS)
+ * @return 无
+ * @note 中断中调用Stepper_LimitEvent，朝限位方向运动的电机在一步内停止并锁存位置；
+ *       电机还需用Stepper_EnableLimitSwitches使能限位
+ */
+void bsp_InitLimit(const LimitInput_t* inputs, uint8_t count);
+
+/**
+ * @brief 读取限位输入状态
+ * @param index 输入序号
+ * @return 1 触发  0 释放
+ */
+uint8_t Limit_Read(uint8_t index);
+
+#endif // !__BSP_LIMIT_H
@@ -6,15 +6,127 @@
 #include "bsp_motor.h"
 #include <stdlib.h>
 
-// 系统时间(单位:1us)
-uint64_t __IO g_motor_system_time = 0;            
-
 // 全局链表头指针，用于管理所有电机
 static StepperMotor_t* g_stepper_list = NULL;
 
+// 定时器比较通道与电机的对应关系
+static StepperMotor_t* s_channel_motor[STEPPER_TIM_CHANNELS] = {NULL};
+static uint8_t s_timer_ready = 0;
+
+// DMA脉冲序列: 正在填充的半缓冲区和当前边沿时刻(相对半缓冲区起点，us)，
+// 以及从现在到这半个缓冲区开始输出的时间
+static uint32_t* const* s_dma_words = NULL;
+static uint32_t s_dma_time = 0;
+static uint32_t s_dma_lead = 0;
+static uint32_t s_dma_base = 0;     // 已填充的缓冲区时长累计(us)，作为DMA边沿的时间戳基准
+
+// 比较中断: 当前边沿的比较点到中断执行时已经过的时间(us)，PWM输出按比较点对齐
+static uint16_t s_edge_lag = 0;
+
+// 同一次中断/轮询中到期的STEP边沿按端口合并为一次BSRR写入
+#define STEPPER_BATCH_PORTS         3       // GPIOA、GPIOB、GPIOF
+typedef struct {
+    GPIO_TypeDef* port[STEPPER_BATCH_PORTS];
+    uint32_t bsrr[STEPPER_BATCH_PORTS];
+    uint8_t count;
+} StepperPulseBatch_t;
+static StepperPulseBatch_t* s_pulse_batch = NULL;
+
+// 引脚描述方式的DIR/EN输出，以及最近一次移位输出的映像序号和时刻
+static StepperExpanderFunc_t s_expander_write = NULL;
+static volatile uint32_t s_expander_seq = 0;
+static volatile uint32_t s_expander_time = 0;
+
+// DMA脉冲序列的边沿撤销函数(限位中断中使用)
+static StepperDmaCancelFunc_t s_dma_cancel = NULL;
+
+// 步进时序跟踪: 选中电机的上升沿间隔环形缓冲区
+static uint16_t s_trace_ring[STEPPER_TRACE_SIZE];
+static uint16_t s_trace_head = 0;
+static uint16_t s_trace_count = 0;
+static StepperMotor_t* s_trace_motor = NULL;
+
+// 临界区保护(主循环与比较中断共享DIER和电机状态)
+#define STEPPER_ENTER_CRITICAL()    uint32_t _primask = __get_PRIMASK(); __disable_irq()
+#define STEPPER_EXIT_CRITICAL()     __set_PRIMASK(_primask)
+
 // 私有函数声明
 static void Stepper_SetDirection(StepperMotor_t* motor, StepperDirection_t dir);
 static void Stepper_TogglePulse(StepperMotor_t* motor);
+static void Stepper_PulseOut(StepperMotor_t* motor, uint8_t level);
+static void Stepper_PinWrite(StepperMotor_t* motor, StepperPinType_t type, uint8_t level);
+static void Stepper_BatchFlush(const StepperPulseBatch_t* batch);
+static uint8_t Stepper_IoReady(StepperMotor_t* motor);
+static uint8_t Stepper_Replan(StepperMotor_t* motor, uint32_t target, uint32_t max_speed, uint8_t stop);
+static uint32_t Stepper_Edge(StepperMotor_t* motor);
+static void Stepper_Start(StepperMotor_t* motor);
+static void Stepper_Disarm(StepperMotor_t* motor);
+static void Stepper_BuildRampTable(StepperMotor_t* motor);
+static uint32_t Stepper_RampDelay(const StepperMotor_t* motor, uint32_t count);
+static void Stepper_PrepareProfile(StepperMotor_t* motor);
+static void Stepper_ProfileStart(StepperMotor_t* motor, uint32_t steps);
+static uint32_t Stepper_LinearNextDelay(StepperMotor_t* motor, uint32_t remain_distance);
+static uint32_t Stepper_ConstAccelNextDelay(StepperMotor_t* motor, uint32_t remain_distance);
+static uint32_t Stepper_TableNextDelay(StepperMotor_t* motor, uint32_t remain_distance);
+static void Stepper_BuildSCurveTable(StepperMotor_t* motor, uint32_t vmax);
+static uint32_t Stepper_SCurveDistance(const StepperMotor_t* motor, uint32_t vmax);
+static uint8_t Stepper_SyncLimit(StepperMotor_t* motor);
+static void Stepper_GearEdge(StepperMotor_t* motor, uint8_t level);
+static void Stepper_HaltAxis(StepperMotor_t* axis);
+static void Stepper_SyncRelease(StepperMotor_t* motor);
+static StepperMotor_t* Stepper_BlockSetup(const StepperBlock_t* block);
+static uint32_t Stepper_BlockChain(StepperMotor_t* motor, const StepperBlock_t* block);
+static void Stepper_ArmAfter(StepperMotor_t* motor, uint32_t delay);
+static int32_t Stepper_BacklashSteps(const StepperMotor_t* motor);
+static void Stepper_Rebase(StepperMotor_t* motor);
+static void Stepper_EncoderSample(StepperMotor_t* motor);
+static void Stepper_EncoderCorrect(StepperMotor_t* motor, int32_t extra);
+static void Stepper_EncoderPoll(StepperMotor_t* motor);
+static uint32_t Stepper_ProfileNextDelay(StepperMotor_t* motor, uint32_t remain_distance);
+static void Stepper_SegmentStart(StepperMotor_t* motor, uint32_t steps);
+static void Stepper_SegmentFill(StepperMotor_t* motor);
+static uint8_t Stepper_SegmentNext(StepperMotor_t* motor);
+static uint32_t Stepper_CruiseSteps(const StepperMotor_t* motor, uint32_t remain);
+static uint32_t Stepper_PwmHandoff(StepperMotor_t* motor, uint32_t delay, uint32_t steps);
+static void Stepper_PwmCut(StepperMotor_t* motor);
+static void Stepper_PwmRetime(StepperMotor_t* motor, uint32_t early);
+static uint32_t Stepper_EdgeLead(uint32_t delay);
+static uint32_t Stepper_StepPeriod(StepperMotor_t* motor, uint32_t delay);
+static uint32_t Stepper_SpeedDelay(const StepperMotor_t* motor, uint32_t speed);
+static void Stepper_TraceEdge(StepperMotor_t* motor);
+
+/**
+ * @brief 初始化步进脉冲引擎定时器
+ */
+void Stepper_TimerInit(void)
+{
+    TIM_HandleTypeDef TimHandle = {0};
+
+    STEPPER_TIM_CLK_ENABLE();
+
+    /* 计数器自由运行，计1次为1us，比较通道只产生中断不输出到引脚 */
+    TimHandle.Instance = STEPPER_TIM;
+    TimHandle.Init.Prescaler         = SystemCoreClock / 1000000 - 1;
+    TimHandle.Init.Period            = 0xFFFF;
+    TimHandle.Init.ClockDivision     = 0;
+    TimHandle.Init.CounterMode       = TIM_COUNTERMODE_UP;
+    TimHandle.Init.RepetitionCounter = 0;
+    TimHandle.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+
+    if (HAL_TIM_Base_Init(&TimHandle) != HAL_OK) {
+        printf("Stepper timer init error\r\n");
+        return;
+    }
+
+    STEPPER_TIM->DIER &= ~(TIM_IT_CC1 | TIM_IT_CC2 | TIM_IT_CC3 | TIM_IT_CC4);
+    STEPPER_TIM->SR = 0;
+
+    HAL_NVIC_SetPriority(STEPPER_TIM_CC_IRQn, 0, 0);
+    HAL_NVIC_EnableIRQ(STEPPER_TIM_CC_IRQn);
+
+    HAL_TIM_Base_Start(&TimHandle);
+    s_timer_ready = 1;
+}
 
 /**
  * @brief 注册步进电机引脚控制回调函数
@@ -39,31 +151,143 @@ void Stepper_Init(StepperMotor_t* motor, PinControlFunc_t pinControlFunc)
     
     // 注册引脚控制回调函数
     motor->PinControl = pinControlFunc;
+    motor->pins = NULL;
     
     // 设置默认速度参数
-    motor->step_delay = 1000;      // 默认延时1ms
-    motor->min_step_delay = 500;   // 最小延时0.5ms (最大速度2000步/秒)
-    motor->max_step_delay = 2000;  // 最大延时2ms (启动速度500步/秒)
+    motor->step_delay = 1000 << 8;      // 默认延时1ms
+    motor->min_step_delay = 500 << 8;   // 最小延时0.5ms (最大速度2000步/秒)
+    motor->max_step_delay = 2000 << 8;  // 最大延时2ms (启动速度500步/秒)
     motor->accel_steps = 100;      // 加速步数
+    motor->profile = STEPPER_PROFILE_LINEAR;
+    motor->max_speed = 2000;
+    motor->start_speed = 500;
+    motor->speed_delay = motor->min_step_delay;
+    motor->start_delay = motor->max_step_delay;
+    motor->accel = 0;
+    motor->jerk = 0;
+    motor->ramp_vmax = 0;
+    motor->accel_n0 = 0;
+    motor->ramp_c0 = motor->max_step_delay;
+    motor->ramp_c = motor->ramp_c0;
+    Stepper_BuildRampTable(motor);
+    
+    // 默认单位为1微步
+    motor->dir_invert = 0;
+    Stepper_SetUnits(motor, 1UL << 16, 1, 0);
     
     // 初始化时间控制
     motor->last_step_time = 0;
+    motor->edge_delay = 0;
+    motor->step_period = 1000;
+    motor->step_phase = 0;
+    motor->wait_ticks = 0;
     motor->pulse_state = 0;
-    // 移除 pulse_width 初始化
+    motor->timer_channel = STEPPER_CHANNEL_NONE;
     
     // 初始化限位开关
     motor->limit_enabled = 0;      // 默认禁用限位开关
     motor->cw_limit = 0;
     motor->ccw_limit = 0;
+    motor->latch_position = 0;
+    motor->latch_valid = 0;
+    
+    // 反向间隙补偿(默认不补偿)，编码器闭环(默认开环)
+    motor->backlash = 0;
+    motor->enc_read = NULL;
+    motor->enc_scale = 1L << 16;
+    motor->enc_window = 0;
+    motor->enc_stall = 0;
+    motor->enc_corrected = 0;
+    motor->enc_corrections = 0;
+    Stepper_Rebase(motor);
+    
+    // 初始化步段流水线(默认禁用)
+    motor->seg_head = 0;
+    motor->seg_tail = 0;
+    motor->seg_enabled = 0;
+    motor->seg_active = 0;
+    motor->seg_left = 0;
+    motor->plan_remain = 0;
+    motor->seg_underrun = 0;
+    motor->seg_depth_min = STEPPER_SEG_RING - 1;
+    
+    // 初始化运动段队列
+    motor->block_func = NULL;
+    motor->block_ctx = NULL;
+    motor->exit_count = 0;
+    motor->block_active = 0;
+    motor->retarget = 0;
+    motor->retarget_pending = 0;
+    motor->jog_speed = 0;
+    
+    // 初始化直线插补
+    motor->sync_master = NULL;
+    motor->sync_next = NULL;
+    motor->dda_num = 0;
+    motor->dda_den = 0;
+    motor->dda_err = 0;
+    
+    // 初始化电子齿轮(默认不跟随)
+    motor->gear_master = NULL;
+    motor->gear_list = NULL;
+    motor->gear_next = NULL;
+    motor->gear_num = 0;
+    motor->gear_den = 1;
+    motor->gear_err = 0;
+    motor->gear_reverse = 0;
+    
+    // 初始化DMA脉冲序列(默认不使用)
+    motor->dma_port = STEPPER_DMA_NONE;
+    motor->dma_run = 0;
+    motor->dma_pin = 0;
+    motor->dma_next = 0;
+    
+    // 初始化匀速段PWM输出(默认不使用)
+    motor->pwm_ops = NULL;
+    motor->pwm_busy = 0;
+    motor->seg_pwm = 0;
+    motor->pwm_period = 0;
+    motor->pwm_accel_count = 0;
+    
+    // 初始化步进时序跟踪(默认关闭)
+    motor->trace_on = 0;
+    motor->trace_valid = 0;
+    motor->trace_last = 0;
+    motor->trace_period = 0;
+    motor->trace_err_min = INT16_MAX;
+    motor->trace_err_max = INT16_MIN;
+    motor->trace_err_sum = 0;
+    motor->trace_err_span = 0;
+    motor->trace_count = 0;
+    
+    // 初始化扩展输出等待
+    motor->io_seq = 0;
+    motor->io_pending = 0;
+    motor->io_wait = 0;
     
     // 初始化链表指针
     motor->next = NULL;
     
     // 设置引脚状态(如果已注册回调函数)
     if (motor->PinControl != NULL) {
-        motor->PinControl(PIN_TYPE_PWM, 0);  // PWM引脚低电平
-        motor->PinControl(PIN_TYPE_DIR, (motor->dir == STEPPER_DIR_CW) ? 0 : 1);  // 方向引脚
-        motor->PinControl(PIN_TYPE_EN, 1);  // 使能引脚高电平(禁用电机)
+        Stepper_PinWrite(motor, PIN_TYPE_PWM, 0);  // PWM引脚低电平
+        Stepper_PinWrite(motor, PIN_TYPE_DIR, (motor->dir == STEPPER_DIR_CW) ? 0 : 1);  // 方向引脚
+        Stepper_PinWrite(motor, PIN_TYPE_EN, 1);  // 使能引脚高电平(禁用电机)
+    }
+    
+    // 分配空闲的定时器比较通道(已分配过的不重复分配)
+    if (s_timer_ready) {
+        for (uint8_t ch = 0; ch < STEPPER_TIM_CHANNELS; ch++) {
+            if (s_channel_motor[ch] == motor) {
+                motor->timer_channel = ch;
+                break;
+            }
+            if (s_channel_motor[ch] == NULL) {
+                s_channel_motor[ch] = motor;
+                motor->timer_channel = ch;
+                break;
+            }
+        }
     }
     
     // 添加到电机管理列表
@@ -75,226 +299,1781 @@ void Stepper_Init(StepperMotor_t* motor, PinControlFunc_t pinControlFunc)
  */
 void Stepper_SetSpeed(StepperMotor_t* motor, uint32_t max_speed, uint32_t start_speed, uint32_t accel)
 {
-    // 速度转换为延时
+    // 保存速度参数并转换为延时(Q8，us)，切换曲线类型时重新计算
     if (max_speed > 0) {
-        motor->min_step_delay = 1000000 / max_speed; // 将步/秒转换为us延时
+        motor->max_speed = max_speed;
+        motor->speed_delay = 256000000UL / max_speed;
     }
-    
     if (start_speed > 0) {
-        motor->max_step_delay = 1000000 / start_speed; // 将步/秒转换为us延时
+        motor->start_speed = start_speed;
+        motor->start_delay = 256000000UL / start_speed;
     }
+    motor->accel = accel;
+    
+    Stepper_PrepareProfile(motor);
     
     // 设置当前步进延时为最大延时(启动速度)
     motor->step_delay = motor->max_step_delay;
+}
+
+/**
+ * @brief 按小数速度设置步进电机速度参数
+ */
+void Stepper_SetSpeedQ16(StepperMotor_t* motor, uint32_t max_speed, uint32_t start_speed, uint32_t accel)
+{
+    uint64_t delay;
     
-    // 设置加速步数
-    if (accel > 0) {
-        // 计算所需加速步数: 加速度 = 速度差/时间，步数 = 速度差^2/(2*加速度)
-        uint32_t speed_diff = max_speed - start_speed;
-        motor->accel_steps = (speed_diff * speed_diff) / (2 * accel);
-        
-        // 确保至少有一个加速步骤
-        if (motor->accel_steps < 1) {
-            motor->accel_steps = 1;
-        }
-    } else {
-        motor->accel_steps = 0; // 不进行加减速
+    // 延时 = 2^24*10^6/速度(Q8，us)；曲线计算用的整数速度四舍五入，至少为1
+    if (max_speed > 0) {
+        delay = (1000000ULL << 24) / max_speed;
+        motor->max_speed = (max_speed >= 0x18000) ? (max_speed + 0x8000) >> 16 : 1;
+        motor->speed_delay = (delay > STEPPER_DELAY_MAX_Q8) ? STEPPER_DELAY_MAX_Q8 : (uint32_t)delay;
+    }
+    if (start_speed > 0) {
+        delay = (1000000ULL << 24) / start_speed;
+        motor->start_speed = (start_speed >= 0x18000) ? (start_speed + 0x8000) >> 16 : 1;
+        motor->start_delay = (delay > STEPPER_DELAY_MAX_Q8) ? STEPPER_DELAY_MAX_Q8 : (uint32_t)delay;
     }
+    motor->accel = accel;
+    
+    Stepper_PrepareProfile(motor);
+    motor->step_delay = motor->max_step_delay;
 }
 
 /**
- * @brief 设置步进电机目标位置(相对运动)
+ * @brief 读取步进电机速度参数
  */
-void Stepper_Move(StepperMotor_t* motor, uint32_t steps, StepperDirection_t dir)
+void Stepper_GetSpeed(const StepperMotor_t* motor, StepperSpeed_t* speed)
 {
-    // 设置方向
-    Stepper_SetDirection(motor, dir);
+    speed->max_speed = motor->max_speed;
+    speed->start_speed = motor->start_speed;
+    speed->speed_delay = motor->speed_delay;
+    speed->start_delay = motor->start_delay;
+    speed->accel = motor->accel;
+}
+
+/**
+ * @brief 恢复Stepper_GetSpeed读取的速度参数
+ */
+void Stepper_RestoreSpeed(StepperMotor_t* motor, const StepperSpeed_t* speed)
+{
+    motor->max_speed = speed->max_speed;
+    motor->start_speed = speed->start_speed;
+    motor->speed_delay = speed->speed_delay;
+    motor->start_delay = speed->start_delay;
+    motor->accel = speed->accel;
     
-    // 计算目标位置
-    if (dir == STEPPER_DIR_CW) {
-        motor->target_position = motor->position + steps;
-        printf("Motor moving CW to %d steps\r\n", motor->target_position);
-    } else {
-        motor->target_position = motor->position - steps;
-        printf("Motor moving CCW to %d steps\r\n", motor->target_position);
+    Stepper_PrepareProfile(motor);
+    motor->step_delay = motor->max_step_delay;
+}
+
+/**
+ * @brief 设置工程单位换算参数
+ */
+uint8_t Stepper_SetUnits(StepperMotor_t* motor, uint32_t steps_per_unit, uint16_t microstep, uint8_t invert)
+{
+    uint64_t scale = (uint64_t)steps_per_unit * microstep;
+    uint8_t bits = 0;
+    
+    invert = invert ? 1 : 0;
+    if (scale == 0 || scale > 0xFFFFFFFFUL || microstep > STEPPER_MICROSTEP_MAX) {
+        return 0;
+    }
+    if (invert != motor->dir_invert && motor->state != STEPPER_STATE_IDLE) {
+        return 0;
     }
     
-    // 设置初始速度为启动速度
-    motor->step_delay = motor->max_step_delay;
+    motor->steps_per_unit = steps_per_unit;
+    motor->microstep = microstep;
+    motor->unit_scale = (uint32_t)scale;
     
-    // 更新电机状态
-    if (motor->accel_steps > 0 && steps > motor->accel_steps * 2) {
-        motor->state = STEPPER_STATE_ACCELERATING;
-    } else {
-        motor->state = STEPPER_STATE_RUNNING;
+    // 倒数归一化到2^30~2^32之间: unit_shift = 14+位数，2^(unit_shift+16)/scale不超过32位
+    while (scale >> bits) {
+        bits++;
     }
+    motor->unit_shift = 14 + bits;
+    motor->unit_recip = (uint32_t)((1ULL << (motor->unit_shift + 16)) / motor->unit_scale);
     
-    // 重要：重置脉冲状态，确保从低电平开始
-    motor->pulse_state = 0;
-    if (motor->PinControl != NULL) {
-        motor->PinControl(PIN_TYPE_PWM, 0);
+    if (invert != motor->dir_invert) {
+        motor->dir_invert = invert;
+        Stepper_PinWrite(motor, PIN_TYPE_DIR, (motor->dir == STEPPER_DIR_CW) ? 0 : 1);
     }
+    return 1;
+}
+
+/**
+ * @brief 单位换算为微步数(四舍五入)
+ */
+int32_t Stepper_UnitsToSteps(StepperMotor_t* motor, int32_t units)
+{
+    uint32_t mag = (units < 0) ? 0U - (uint32_t)units : (uint32_t)units;
+    uint64_t steps = ((uint64_t)mag * motor->unit_scale + 0x8000) >> 16;
     
-    // 使能电机
-    Stepper_Enable(motor, 1);
+    if (steps > 0x7FFFFFFF) {
+        steps = 0x7FFFFFFF;
+    }
+    return (units < 0) ? -(int32_t)steps : (int32_t)steps;
 }
 
 /**
- * @brief 设置步进电机目标位置(绝对运动)
+ * @brief 微步数换算为单位(四舍五入)
  */
-void Stepper_MoveTo(StepperMotor_t* motor, uint32_t position)
+int32_t Stepper_StepsToUnits(StepperMotor_t* motor, int32_t steps)
 {
-    // 计算移动方向和步数
-    StepperDirection_t dir;
-    uint32_t steps;
+    uint32_t mag = (steps < 0) ? 0U - (uint32_t)steps : (uint32_t)steps;
+    uint64_t units = ((uint64_t)mag * motor->unit_recip + (1ULL << (motor->unit_shift - 1))) >> motor->unit_shift;
     
-    if (position > motor->position) {
-        dir = STEPPER_DIR_CW;
-        steps = position - motor->position;
-    } else {
-        dir = STEPPER_DIR_CCW;
-        steps = motor->position - position;
+    if (units > 0x7FFFFFFF) {
+        units = 0x7FFFFFFF;
     }
+    return (steps < 0) ? -(int32_t)units : (int32_t)units;
+}
+
+/**
+ * @brief 单位/秒(或单位/秒^2)换算为步/秒，结果为Q(16-shift)，超出32位时取最大值
+ */
+static uint32_t Stepper_UnitRate(const StepperMotor_t* motor, uint32_t rate, uint8_t shift)
+{
+    uint64_t steps = (uint64_t)rate * motor->unit_scale;
     
-    // 执行相对运动
-    Stepper_Move(motor, steps, dir);
+    if (shift > 0) {
+        steps = (steps + (1UL << (shift - 1))) >> shift;
+    }
+    return (steps > 0xFFFFFFFFUL) ? 0xFFFFFFFFUL : (uint32_t)steps;
 }
 
 /**
- * @brief 停止步进电机
+ * @brief 按工程单位设置速度参数
  */
-void Stepper_Stop(StepperMotor_t* motor, uint8_t immediate)
+void Stepper_SetSpeedUnits(StepperMotor_t* motor, uint32_t max_speed, uint32_t start_speed, uint32_t accel)
 {
-    if (immediate) {
-        // 立即停止
-        motor->state = STEPPER_STATE_IDLE;
-        motor->target_position = motor->position;
-    } else {
-        // 减速停止
-        if (motor->state != STEPPER_STATE_IDLE) {
-            motor->state = STEPPER_STATE_DECELERATING;
-            
-            // 根据当前位置和减速度计算新的目标位置
-            if (motor->dir == STEPPER_DIR_CW) {
-                motor->target_position = motor->position + motor->accel_steps;
-            } else {
-                motor->target_position = motor->position - motor->accel_steps;
-            }
-        }
+    Stepper_SetSpeedQ16(motor, Stepper_UnitRate(motor, max_speed, 0), Stepper_UnitRate(motor, start_speed, 0),
+                        Stepper_UnitRate(motor, accel, 16));
+}
+
+/**
+ * @brief 整数速度对应的延时(Q8，us)，等于设定的最大速度或启动速度时取设定的小数速度
+ */
+static uint32_t Stepper_SpeedDelay(const StepperMotor_t* motor, uint32_t speed)
+{
+    if (speed == motor->max_speed) {
+        return motor->speed_delay;
+    }
+    if (speed == motor->start_speed) {
+        return motor->start_delay;
     }
+    return 256000000UL / speed;
 }
 
 /**
- * @brief 使能步进电机
+ * @brief 设置步进电机加减速曲线类型
  */
-void Stepper_Enable(StepperMotor_t* motor, uint8_t enable)
+void Stepper_SetProfile(StepperMotor_t* motor, StepperProfile_t profile)
 {
-    if (motor->PinControl != NULL) {
-        if (enable) {
-            motor->PinControl(PIN_TYPE_EN, 0); // 低电平使能
-        } else {
-            motor->PinControl(PIN_TYPE_EN, 1); // 高电平禁用
-            motor->state = STEPPER_STATE_IDLE; // 禁用时设为空闲状态
-        }
+    if (motor == NULL) {
+        return;
     }
+    
+    motor->profile = profile;
+    Stepper_PrepareProfile(motor);
 }
 
 /**
- * @brief 步进电机周期性处理函数
+ * @brief 设置S曲线的加加速度
  */
-void Stepper_Handler(StepperMotor_t* motor)
+void Stepper_SetJerk(StepperMotor_t* motor, uint32_t jerk)
 {
-    // 快速检查 - 如果电机空闲，直接返回
-    if (motor->state == STEPPER_STATE_IDLE) {
+    if (motor == NULL) {
         return;
     }
     
-    uint64_t current_time = g_motor_system_time; // 获取当前系统时间
-    uint32_t time_diff = current_time - motor->last_step_time;
-    uint32_t half_period = motor->step_delay >> 1; // 位移操作代替除法
+    motor->jerk = jerk;
+    Stepper_PrepareProfile(motor);
+}
+
+/**
+ * @brief 根据速度参数和曲线类型计算加速步数及预计算数据
+ */
+static void Stepper_PrepareProfile(StepperMotor_t* motor)
+{
+    uint32_t max_speed = motor->max_speed;
+    uint32_t start_speed = motor->start_speed;
+    uint32_t accel = motor->accel;
+    
+    if (start_speed > max_speed) {
+        start_speed = max_speed;
+    }
+    
+    // 延时取设定速度的换算值(运动段和运行中重新规划会临时改写)
+    motor->min_step_delay = motor->speed_delay;
+    motor->max_step_delay = motor->start_delay;
     
-    // 如果时间差小于半周期，无需处理
-    if (time_diff < half_period) {
+    motor->ramp_vmax = 0;
+    
+    if (motor->profile == STEPPER_PROFILE_SCURVE && accel > 0) {
+        motor->accel_n0 = 0;
+        Stepper_BuildSCurveTable(motor, max_speed);
         return;
     }
     
-    // 检查限位开关状态 - 只在需要时检查
-    if (motor->limit_enabled) {
-        uint8_t limit_triggered = (motor->dir == STEPPER_DIR_CW) ? 
-                                motor->cw_limit : motor->ccw_limit;
+    if (motor->profile == STEPPER_PROFILE_CONST_ACCEL && accel > 0) {
+        // 从静止加速到速度v需要 n = v^2/(2a) 步，加速步数为两速度序号之差
+        uint32_t two_a = 2 * accel;
+        uint32_t n_max = (uint32_t)(((uint64_t)max_speed * max_speed) / two_a);
         
-        if (limit_triggered) {
-            motor->state = STEPPER_STATE_IDLE;
-            
-            // 如果是回归零点操作，重置位置
-            if (motor->dir == STEPPER_DIR_CCW && motor->ccw_limit) {
-                motor->position = 0;
-                motor->target_position = 0;
+        motor->accel_n0 = (uint32_t)(((uint64_t)start_speed * start_speed) / two_a);
+        motor->accel_steps = (n_max > motor->accel_n0) ? (n_max - motor->accel_n0) : 0;
+        
+        // 启动延时取启动速度，静止起步时不超过第一步的理论延时 c0 = 0.676*sqrt(2/a)*1e6
+        motor->ramp_c0 = motor->max_step_delay;
+        if (motor->accel_n0 == 0) {
+            uint32_t c0 = (956008UL << 12) / Stepper_Sqrt((uint64_t)accel << 8);
+            if (c0 < motor->ramp_c0) {
+                motor->ramp_c0 = c0;
             }
-            return;
         }
+        motor->ramp_c = motor->ramp_c0;
+        
+        Stepper_BuildRampTable(motor);
+        return;
     }
     
-    // 更新脉冲时间
-    motor->last_step_time = current_time;
+    motor->accel_n0 = 0;
+    motor->ramp_c0 = motor->max_step_delay;
+    motor->ramp_c = motor->ramp_c0;
     
-    // 处理脉冲状态
-    if (motor->pulse_state == 0) {
-        // 脉冲上升沿
-        if (motor->PinControl != NULL) {
-            motor->PinControl(PIN_TYPE_PWM, 1);
+    // 设置加速步数
+    if (accel > 0) {
+        // 计算所需加速步数: 加速度 = 速度差/时间，步数 = 速度差^2/(2*加速度)
+        uint32_t speed_diff = max_speed - start_speed;
+        motor->accel_steps = (speed_diff * speed_diff) / (2 * accel);
+        
+        // 确保至少有一个加速步骤
+        if (motor->accel_steps < 1) {
+            motor->accel_steps = 1;
         }
-        motor->pulse_state = 1;
-        return; // 直接返回，等待下半周期
+    } else {
+        motor->accel_steps = 0; // 不进行加减速
     }
     
-    // 脉冲下降沿 - 完成一步
-    if (motor->PinControl != NULL) {
-        motor->PinControl(PIN_TYPE_PWM, 0);
+    // 预先生成加减速延时表
+    Stepper_BuildRampTable(motor);
+}
+
+/**
+ * @brief 生成加减速延时表
+ * @note 延时随加速步数线性变化，表按加速步数等分，查表时段内插值
+ */
+static void Stepper_BuildRampTable(StepperMotor_t* motor)
+{
+    uint32_t span = (motor->max_step_delay > motor->min_step_delay) ? 
+                    (motor->max_step_delay - motor->min_step_delay) : 0;
+    
+    for (uint32_t i = 0; i <= STEPPER_RAMP_SEGMENTS; i++) {
+        motor->ramp_table[i] = motor->max_step_delay - (uint32_t)(((uint64_t)span * i) / STEPPER_RAMP_SEGMENTS);
     }
-    motor->pulse_state = 0;
     
-    // 更新位置 - 使用三目运算简化
-    motor->position += (motor->dir == STEPPER_DIR_CW) ? 1 : -1;
+    // 比例向上取整，保证查表位置不落后于实际步数
+    motor->ramp_scale = (motor->accel_steps > 0) ? 
+                        (((uint32_t)STEPPER_RAMP_SEGMENTS << 24) + motor->accel_steps - 1) / motor->accel_steps : 0;
+}
+
+/**
+ * @brief 查表获取加减速第count步的延时
+ * @param count 距离启动速度的步数(加速时为已加速步数，减速时为剩余步数)
+ * @return 步进延时(Q8，us)
+ */
+static uint32_t Stepper_RampDelay(const StepperMotor_t* motor, uint32_t count)
+{
+    if (count >= motor->accel_steps) {
+        return motor->ramp_table[STEPPER_RAMP_SEGMENTS];
+    }
     
-    // 检查是否达到目标位置
-    uint8_t reached_target = (motor->dir == STEPPER_DIR_CW) ? 
-                           (motor->position >= motor->target_position) : 
-                           (motor->position <= motor->target_position);
+    // 表位置: 高8位为段号，其后12位为段内插值系数
+    uint32_t pos = count * motor->ramp_scale;
     
-    if (reached_target) {
-        motor->state = STEPPER_STATE_IDLE;
-        return;
+    // 比例向上取整，加减速步数超过2^14时最后几步会越过末段，限制在末段终点
+    if ((pos >> 24) >= STEPPER_RAMP_SEGMENTS) {
+        pos = ((uint32_t)STEPPER_RAMP_SEGMENTS << 24) - (1UL << 12);
     }
+    const uint32_t* t = &motor->ramp_table[pos >> 24];
+    uint32_t frac = (pos >> 12) & 0xFFF;
+    uint32_t diff = t[0] - t[1];
     
-    // 计算下一步延时
-    uint32_t next_delay = motor->step_delay; // 默认保持当前延时
+    // 段内延时差超过2^20(4096us，启动速度很低)时乘积超出32位
+    if (diff >= (1UL << 20)) {
+        return t[0] - (uint32_t)(((uint64_t)diff * frac + 0x800) >> 12);
+    }
+    return t[0] - ((diff * frac + 0x800) >> 12);
+}
+
+/**
+ * @brief 按引脚描述初始化步进电机
+ */
+void Stepper_InitPins(StepperMotor_t* motor, const StepperPinDesc_t* pins)
+{
+    Stepper_Init(motor, NULL);
+    motor->pins = pins;
     
-    // 计算剩余距离 - 只计算一次
-    uint32_t remain_distance = (motor->dir == STEPPER_DIR_CW) ? 
-                             (motor->target_position - motor->position) : 
-                             (motor->position - motor->target_position);
+    if (pins != NULL) {
+        Stepper_PinWrite(motor, PIN_TYPE_PWM, 0);
+        Stepper_PinWrite(motor, PIN_TYPE_DIR, (motor->dir == STEPPER_DIR_CW) ? 0 : 1);
+        Stepper_PinWrite(motor, PIN_TYPE_EN, 1);
+    }
+}
+
+/**
+ * @brief 注册扩展输出写函数
+ */
+void Stepper_SetExpander(StepperExpanderFunc_t func)
+{
+    s_expander_write = func;
+}
+
+/**
+ * @brief 通知扩展输出映像已移位输出
+ */
+void Stepper_ExpanderFlushed(uint32_t seq)
+{
+    s_expander_time = bsp_GetTimeUs();
+    s_expander_seq = seq;
+}
+
+/**
+ * @brief 检查单个电机及其跟随轴的DIR/EN是否已经生效，已生效的清除等待标志
+ * @return 1 已生效  0 还要等待
+ */
+static uint8_t Stepper_IoSettled(StepperMotor_t* axis)
+{
+    uint8_t ready = 1;
     
-    // 根据状态更新速度
-    switch (motor->state) {
-        case STEPPER_STATE_ACCELERATING:
-        {
-            // 使用电机结构体存储加速步数，而不是静态变量
-            motor->accel_count++;
-            
-            if (motor->accel_count < motor->accel_steps) {
-                // 使用查表法或预计算的方式可以进一步优化
-                next_delay = motor->max_step_delay - 
-                    ((motor->max_step_delay - motor->min_step_delay) * motor->accel_count) / motor->accel_steps;
-                
-                // 确保不小于最小延时
-                if (next_delay < motor->min_step_delay) {
-                    next_delay = motor->min_step_delay;
-                }
-                
-                // 提前进入减速阶段
-                if (remain_distance <= motor->accel_steps) {
-                    motor->state = STEPPER_STATE_DECELERATING;
+    if (axis->io_pending) {
+        if ((int32_t)(s_expander_seq - axis->io_seq) < 0 ||
+            bsp_GetTimeUs() - s_expander_time < STEPPER_IO_SETUP_US) {
+            ready = 0;
+        } else {
+            axis->io_pending = 0;
+        }
+    }
+    
+    for (StepperMotor_t* gear = axis->gear_list; gear != NULL; gear = gear->gear_next) {
+        if (!Stepper_IoSettled(gear)) {
+            ready = 0;
+        }
+    }
+    return ready;
+}
+
+/**
+ * @brief 检查电机及其从动轴、跟随轴的DIR/EN是否已经生效
+ * @return 1 已生效  0 还要等待
+ */
+static uint8_t Stepper_IoReady(StepperMotor_t* motor)
+{
+    uint8_t ready = 1;
+    
+    for (StepperMotor_t* axis = motor; axis != NULL; axis = axis->sync_next) {
+        if (!Stepper_IoSettled(axis)) {
+            ready = 0;
+        }
+    }
+    return ready;
+}
+
+/**
+ * @brief 设置步进电机目标位置(相对运动)
+ */
+void Stepper_Move(StepperMotor_t* motor, uint32_t steps, StepperDirection_t dir)
+{
+    // 单独运动联动轴时先停止整组插补，跟随轴解除电子齿轮
+    if (motor->sync_master != NULL || motor->sync_next != NULL) {
+        Stepper_Stop(motor, 1);
+    }
+    if (motor->gear_master != NULL) {
+        Stepper_GearDetach(motor);
+    }
+    
+    // 停止正在输出的脉冲，避免与中断同时修改运动参数
+    Stepper_Disarm(motor);
+    motor->retarget_pending = 0;
+    
+    // 设置方向
+    Stepper_SetDirection(motor, dir);
+    
+    // 计算目标位置
+    if (dir == STEPPER_DIR_CW) {
+        motor->target_position = motor->position + steps;
+        printf("Motor moving CW to %d steps\r\n", motor->target_position);
+    } else {
+        motor->target_position = motor->position - steps;
+        printf("Motor moving CCW to %d steps\r\n", motor->target_position);
+    }
+    
+    // 设置初始速度为启动速度并更新电机状态
+    Stepper_ProfileStart(motor, steps);
+    Stepper_SegmentStart(motor, steps);
+    
+    // 使能电机并启动脉冲输出
+    Stepper_Start(motor);
+}
+
+/**
+ * @brief 多轴直线插补运动(绝对位置)
+ */
+void Stepper_MoveLinear(StepperMotor_t* axes[], const uint32_t targets[], uint8_t count)
+{
+    StepperMotor_t* master = NULL;
+    uint32_t steps[STEPPER_LINEAR_MAX_AXES];
+    uint32_t master_steps = 0;
+    uint8_t master_index = 0;
+    
+    if (axes == NULL || targets == NULL || count == 0 || count > STEPPER_LINEAR_MAX_AXES) {
+        return;
+    }
+    
+    // 停止各轴并解除之前的联动关系，步数最多的轴作为主轴
+    for (uint8_t i = 0; i < count; i++) {
+        StepperMotor_t* axis = axes[i];
+        
+        Stepper_Disarm(axis);
+        Stepper_SyncRelease(axis->sync_master != NULL ? axis->sync_master : axis);
+        axis->retarget_pending = 0;
+        if (axis->gear_master != NULL) {
+            Stepper_GearDetach(axis);
+        }
+        
+        if (targets[i] >= axis->position) {
+            steps[i] = targets[i] - axis->position;
+            Stepper_SetDirection(axis, STEPPER_DIR_CW);
+        } else {
+            steps[i] = axis->position - targets[i];
+            Stepper_SetDirection(axis, STEPPER_DIR_CCW);
+        }
+        
+        // 本次不动的轴停止输出(轮询方式的轴不再走向之前的目标)
+        if (steps[i] == 0) {
+            axis->state = STEPPER_STATE_IDLE;
+            axis->target_position = axis->position;
+            continue;
+        }
+        
+        if (steps[i] > master_steps) {
+            master_steps = steps[i];
+            master = axis;
+            master_index = i;
+        }
+    }
+    
+    if (master == NULL) {
+        return;
+    }
+    
+    // 从动轴挂到主轴上，误差初值取半步使步数分布居中
+    for (uint8_t i = 0; i < count; i++) {
+        StepperMotor_t* axis = axes[i];
+        
+        if (axis == master || steps[i] == 0) {
+            continue;
+        }
+        
+        axis->target_position = targets[i];
+        axis->dda_num = steps[i];
+        axis->dda_den = master_steps;
+        axis->dda_err = master_steps >> 1;
+        axis->pulse_state = 0;
+        axis->state = STEPPER_STATE_RUNNING;
+        axis->sync_master = master;
+        axis->sync_next = master->sync_next;
+        master->sync_next = axis;
+        
+        Stepper_PinWrite(axis, PIN_TYPE_PWM, 0);
+        Stepper_Enable(axis, 1);
+    }
+    
+    // 主轴按自身曲线运行，从动轴在主轴的脉冲边沿中输出
+    master->target_position = targets[master_index];
+    Stepper_ProfileStart(master, master_steps);
+    Stepper_SegmentStart(master, master_steps);
+    Stepper_Start(master);
+}
+
+/**
+ * @brief 设置步进电机目标位置(绝对运动)
+ */
+void Stepper_MoveTo(StepperMotor_t* motor, uint32_t position)
+{
+    // 计算移动方向和步数
+    StepperDirection_t dir;
+    uint32_t steps;
+    
+    if (position > motor->position) {
+        dir = STEPPER_DIR_CW;
+        steps = position - motor->position;
+    } else {
+        dir = STEPPER_DIR_CCW;
+        steps = motor->position - position;
+    }
+    
+    // 执行相对运动
+    Stepper_Move(motor, steps, dir);
+}
+
+/**
+ * @brief 按工程单位运动到绝对位置
+ */
+uint8_t Stepper_MoveToUnits(StepperMotor_t* motor, int32_t position)
+{
+    int32_t steps = Stepper_UnitsToSteps(motor, position);
+    
+    if (steps < 0) {
+        return 0;
+    }
+    // 单位位置与Stepper_GetPosition一致，不含补偿步数
+    Stepper_MoveTo(motor, (uint32_t)steps + (motor->position - Stepper_GetPosition(motor)));
+    return 1;
+}
+
+/**
+ * @brief 按工程单位运动相对距离
+ */
+void Stepper_MoveUnits(StepperMotor_t* motor, int32_t distance)
+{
+    int32_t steps = Stepper_UnitsToSteps(motor, distance);
+    
+    if (steps > 0) {
+        Stepper_Move(motor, (uint32_t)steps, STEPPER_DIR_CW);
+    } else if (steps < 0) {
+        Stepper_Move(motor, 0U - (uint32_t)steps, STEPPER_DIR_CCW);
+    }
+}
+
+/**
+ * @brief 运行中修改目标位置
+ */
+void Stepper_UpdateTarget(StepperMotor_t* motor, uint32_t position)
+{
+    if (motor->sync_master != NULL || motor->sync_next != NULL || motor->block_func != NULL ||
+        motor->state == STEPPER_STATE_IDLE) {
+        Stepper_MoveTo(motor, position);
+        return;
+    }
+    
+    motor->retarget_pending = 0;
+    
+    switch (Stepper_Replan(motor, position, motor->max_speed, 0)) {
+        case 0:
+            // 已规划为减速停止，停止后运动到新目标
+            motor->retarget = position;
+            motor->retarget_pending = STEPPER_RETARGET_MOVE;
+            break;
+        case 2:
+            // 重新规划前电机已经停止
+            Stepper_MoveTo(motor, position);
+            break;
+        default:
+            break;
+    }
+}
+
+/**
+ * @brief 运行中修改最大速度
+ */
+void Stepper_UpdateMaxSpeed(StepperMotor_t* motor, uint32_t max_speed)
+{
+    if (max_speed == 0) {
+        return;
+    }
+    
+    if (motor->sync_master != NULL) {
+        motor = motor->sync_master;
+    }
+    
+    // 空闲时只更新参数；队列运动按各段速度执行，新的最大速度在下次独立运动时生效
+    if (motor->state == STEPPER_STATE_IDLE) {
+        Stepper_SetSpeed(motor, max_speed, motor->start_speed, motor->accel);
+        return;
+    }
+    motor->max_speed = max_speed;
+    if (motor->block_func != NULL || motor->retarget_pending) {
+        return;
+    }
+    
+    // 目标不变，从当前速度重新规划(联动组的步数比例不变)
+    if (Stepper_Replan(motor, motor->target_position, max_speed, 0) == 2) {
+        Stepper_SetSpeed(motor, max_speed, motor->start_speed, motor->accel);
+    }
+}
+
+/**
+ * @brief 从当前瞬时速度重新规划到新目标
+ * @param max_speed 重新规划后的匀速速度(步/秒，大于0)
+ * @param stop 1 忽略target，按加速度尽快减速停止(原规划已在减速距离内时不修改)
+ * @return 1 直接运动到新目标  0 反向或来不及减速，已规划为尽快减速停止  2 电机已经停止
+ * @note 规划后按恒加速度递推运行，速度用绝对递推序号 n = v^2/(2a) 表示(与运动段相同)，
+ *       流水线方式下从规划游标处开始(已生成的步段不再修改)。除法在进入临界区之前完成
+ */
+static uint8_t Stepper_Replan(StepperMotor_t* motor, uint32_t target, uint32_t max_speed, uint8_t stop)
+{
+    Stepper_PwmCut(motor);
+    
+    uint32_t start_speed = (motor->start_speed < max_speed) ? motor->start_speed : max_speed;
+    uint32_t delay = motor->step_delay;
+    uint64_t two_a = 2 * (uint64_t)motor->accel;
+    uint32_t n_cur = 0, n_start = 0, n_max = 0;
+    uint32_t min_delay = Stepper_SpeedDelay(motor, max_speed);
+    uint32_t max_delay = (start_speed > 0) ? Stepper_SpeedDelay(motor, start_speed) : motor->max_step_delay;
+    uint8_t result = 1;
+    
+    if (delay < 256) {
+        delay = 256;
+    }
+    if (two_a > 0) {
+        // 当前速度(Q8，步/秒) v = 2^16*10^6/delay，n = v^2/(2a)
+        uint64_t v = 65536000000ULL / delay;
+        n_cur = (uint32_t)((v * v) / (two_a << 16));
+        n_start = (uint32_t)(((uint64_t)start_speed * start_speed) / two_a);
+        n_max = (uint32_t)(((uint64_t)max_speed * max_speed) / two_a);
+    }
+    
+    STEPPER_ENTER_CRITICAL();
+    if (motor->state == STEPPER_STATE_IDLE) {
+        STEPPER_EXIT_CRITICAL();
+        return 2;
+    }
+    
+    // 当前位置: 流水线方式为规划游标处
+    uint32_t pos = motor->position;
+    if (motor->seg_active) {
+        pos = (motor->dir == STEPPER_DIR_CW) ? motor->target_position - motor->plan_remain :
+                                               motor->target_position + motor->plan_remain;
+    }
+    uint8_t ahead = (motor->dir == STEPPER_DIR_CW) ? (target >= pos) : (target <= pos);
+    uint32_t remain = (target >= pos) ? target - pos : pos - target;
+    
+    if (stop) {
+        uint32_t left = motor->seg_active ? motor->plan_remain :
+                        (motor->target_position >= pos) ? motor->target_position - pos :
+                                                          pos - motor->target_position;
+        
+        // 原目标比减速距离近: 原规划已经能减速到启动速度停止
+        if ((uint64_t)left + n_start <= n_cur) {
+            STEPPER_EXIT_CRITICAL();
+            return 0;
+        }
+        ahead = 0;
+    }
+    
+    // 反向或剩余距离不够从当前速度减速到启动速度: 改为在减速距离处停止
+    if (!ahead || (uint64_t)remain + n_start < n_cur) {
+        remain = (n_cur > n_start) ? n_cur - n_start : 0;
+        target = (motor->dir == STEPPER_DIR_CW) ? pos + remain : pos - remain;
+        result = 0;
+    }
+    
+    motor->target_position = target;
+    if (motor->seg_active) {
+        motor->plan_remain = remain;
+    }
+    
+    if (two_a > 0) {
+        motor->block_active = 1;  // 速度参数被改写，下次独立运动前恢复
+        motor->accel_n0 = 0;
+        motor->accel_count = n_cur;
+        motor->exit_count = n_start;
+        motor->accel_steps = n_max;
+        motor->ramp_c = delay;
+        motor->min_step_delay = min_delay;
+        motor->max_step_delay = max_delay;
+        if (result == 0 || remain + n_start <= n_cur) {
+            motor->state = STEPPER_STATE_DECELERATING;
+        } else {
+            motor->state = (n_cur < n_max) ? STEPPER_STATE_ACCELERATING : STEPPER_STATE_RUNNING;
+        }
+    } else if (result == 0) {
+        // 不加减速时立即停止
+        motor->state = STEPPER_STATE_IDLE;
+        motor->target_position = motor->position;
+        motor->plan_remain = 0;
+    } else {
+        motor->min_step_delay = min_delay;
+    }
+    STEPPER_EXIT_CRITICAL();
+    
+    if (motor->state == STEPPER_STATE_IDLE) {
+        Stepper_Disarm(motor);
+    }
+    return result;
+}
+
+/**
+ * @brief 停止步进电机
+ */
+void Stepper_Stop(StepperMotor_t* motor, uint8_t immediate)
+{
+    // 联动轴由主轴统一停止
+    if (motor->sync_master != NULL) {
+        motor = motor->sync_master;
+    }
+    
+    motor->retarget_pending = 0;
+    
+    if (!immediate && motor->accel > 0 &&
+        (motor->block_active || motor->profile != STEPPER_PROFILE_SCURVE)) {
+        // 按当前瞬时速度和设定加速度计算制动距离，从当前速度直接减速到启动速度停止
+        motor->block_func = NULL;  // 停止时不再衔接队列中的下一段
+        Stepper_Replan(motor, motor->position, motor->max_speed, 1);
+        return;
+    }
+    
+    // PWM输出的匀速段截短，从截短处开始减速
+    if (!immediate) {
+        Stepper_PwmCut(motor);
+    }
+    
+    STEPPER_ENTER_CRITICAL();
+    motor->block_func = NULL;  // 停止时不再衔接队列中的下一段
+    if (immediate) {
+        // 立即停止
+        motor->state = STEPPER_STATE_IDLE;
+        motor->target_position = motor->position;
+        motor->plan_remain = 0;
+    } else {
+        // 减速停止
+        if (motor->state != STEPPER_STATE_IDLE) {
+            // S曲线按已加速步数反向查表减速(保持加加速度限制)；
+            // 不加减速时加速步数为0，下一步即停止
+            uint32_t decel_steps = motor->accel_count;
+            
+            // 运动段的加速步数是绝对递推序号，按当前序号减速到启动速度
+            if (motor->block_active) {
+                motor->exit_count = 0;
+            }
+            motor->state = STEPPER_STATE_DECELERATING;
+            
+            if (motor->seg_active) {
+                // 已生成的步段不再修改，从规划游标处开始减速
+                if (decel_steps < motor->plan_remain) {
+                    uint32_t cut = motor->plan_remain - decel_steps;
+                    motor->target_position += (motor->dir == STEPPER_DIR_CW) ? -cut : cut;
+                    motor->plan_remain = decel_steps;
+                }
+            } else if (motor->dir == STEPPER_DIR_CW) {
+                // 根据当前位置和减速步数计算新的目标位置
+                motor->target_position = motor->position + decel_steps;
+            } else {
+                motor->target_position = motor->position - decel_steps;
+            }
+        }
+    }
+    STEPPER_EXIT_CRITICAL();
+    
+    if (motor->state == STEPPER_STATE_IDLE) {
+        Stepper_Disarm(motor);
+        Stepper_SyncRelease(motor);
+    }
+}
+
+/**
+ * @brief 使能步进电机
+ */
+void Stepper_Enable(StepperMotor_t* motor, uint8_t enable)
+{
+    if (motor->PinControl != NULL || motor->pins != NULL) {
+        if (enable) {
+            Stepper_PinWrite(motor, PIN_TYPE_EN, 0); // 低电平使能
+        } else {
+            Stepper_PinWrite(motor, PIN_TYPE_EN, 1); // 高电平禁用
+            motor->state = STEPPER_STATE_IDLE; // 禁用时设为空闲状态
+            Stepper_Disarm(motor);
+            Stepper_SyncRelease(motor);
+        }
+    }
+}
+
+/**
+ * @brief 步进电机周期性处理函数(轮询方式)
+ */
+void Stepper_Handler(StepperMotor_t* motor)
+{
+    // 快速检查 - 如果电机空闲、作为从动轴由主轴驱动或由DMA输出，直接返回
+    if (motor->state == STEPPER_STATE_IDLE || motor->sync_master != NULL ||
+        motor->dma_port != STEPPER_DMA_NONE || motor->io_wait) {
+        return;
+    }
+    
+    uint32_t current_time = bsp_GetTimeUs(); // 获取当前系统时间
+    uint32_t time_diff = current_time - motor->last_step_time;
+    
+    // 未到下一个边沿时间，无需处理
+    if (time_diff < motor->edge_delay) {
+        return;
+    }
+    
+    // 更新脉冲时间
+    motor->last_step_time = current_time;
+    motor->edge_delay = Stepper_Edge(motor);
+}
+
+/**
+ * @brief 产生一个脉冲边沿并计算下一步延时
+ * @param motor 步进电机结构体指针
+ * @return 到下一个边沿的延时(us)，电机停止时state被置为IDLE
+ * @note 轮询方式和定时器比较中断共用此函数
+ */
+static uint32_t Stepper_Edge(StepperMotor_t* motor)
+{
+    StepperMotor_t* axis;
+    
+    // 检查限位开关状态(含从动轴) - 只在需要时检查
+    if (Stepper_SyncLimit(motor)) {
+        Stepper_SyncRelease(motor);
+        return 0;
+    }
+    
+    // 步段欠载后等待主循环填充
+    if (motor->pulse_state == 2) {
+        if (!Stepper_SegmentNext(motor)) {
+            return STEPPER_SEG_RETRY;
+        }
+        motor->pulse_state = 0;
+        return motor->step_period - (motor->step_period >> 1);
+    }
+    
+    // 处理脉冲状态
+    if (motor->pulse_state == 0) {
+        // 脉冲上升沿，从动轴按误差累加决定本步是否同时输出
+        Stepper_PulseOut(motor, 1);
+        motor->pulse_state = 1;
+        Stepper_GearEdge(motor, 1);
+        if (motor->trace_on) {
+            Stepper_TraceEdge(motor);
+        }
+        
+        for (axis = motor->sync_next; axis != NULL; axis = axis->sync_next) {
+            axis->dda_err += axis->dda_num;
+            if (axis->dda_err >= axis->dda_den) {
+                axis->dda_err -= axis->dda_den;
+                Stepper_PulseOut(axis, 1);
+                axis->pulse_state = 1;
+                Stepper_GearEdge(axis, 1);
+            }
+        }
+        // 等待下半周期
+        return motor->step_period >> 1;
+    }
+    
+    // 脉冲下降沿 - 完成一步
+    Stepper_PulseOut(motor, 0);
+    motor->pulse_state = 0;
+    
+    // 更新位置 - 使用三目运算简化
+    motor->position += (motor->dir == STEPPER_DIR_CW) ? 1 : -1;
+    Stepper_GearEdge(motor, 0);
+    
+    // 编码器按步采样(DMA输出的边沿提前生成，由主循环采样)
+    if (motor->enc_read != NULL && motor->dma_port == STEPPER_DMA_NONE) {
+        Stepper_EncoderSample(motor);
+    }
+    
+    for (axis = motor->sync_next; axis != NULL; axis = axis->sync_next) {
+        if (axis->pulse_state) {
+            Stepper_PulseOut(axis, 0);
+            axis->pulse_state = 0;
+            axis->position += (axis->dir == STEPPER_DIR_CW) ? 1 : -1;
+            Stepper_GearEdge(axis, 0);
+        }
+    }
+    
+    // 检查是否达到目标位置
+    uint8_t reached_target = (motor->dir == STEPPER_DIR_CW) ? 
+                           (motor->position >= motor->target_position) : 
+                           (motor->position <= motor->target_position);
+    
+    if (reached_target) {
+        // 队列中还有下一段时直接衔接，不停止
+        if (motor->block_func != NULL) {
+            const StepperBlock_t* block = motor->block_func(motor->block_ctx);
+            if (block != NULL) {
+                return Stepper_BlockChain(motor, block);
+            }
+            motor->block_func = NULL;
+        }
+        
+        motor->state = STEPPER_STATE_IDLE;
+        Stepper_SyncRelease(motor);
+        return 0;
+    }
+    
+    // 流水线方式: 下一步延时取自主循环预先生成的步段
+    if (motor->seg_active) {
+        if (!Stepper_SegmentNext(motor)) {
+            motor->seg_underrun++;
+            motor->pulse_state = 2;
+            return STEPPER_SEG_RETRY;
+        }
+        
+        // 匀速步段交给PWM输出: 在最后一步结束时取下一个步段
+        if (motor->seg_pwm) {
+            motor->seg_pwm = 0;
+            uint32_t span = Stepper_PwmHandoff(motor, motor->seg_delay, (uint32_t)motor->seg_left + 1);
+            if (span > 0) {
+                motor->seg_left = 0;
+                motor->pulse_state = 2;
+                return span;
+            }
+        }
+        return motor->step_period - (motor->step_period >> 1);
+    }
+    
+    // 计算剩余距离 - 只计算一次
+    uint32_t remain_distance = (motor->dir == STEPPER_DIR_CW) ? 
+                             (motor->target_position - motor->position) : 
+                             (motor->position - motor->target_position);
+    
+    // 更新步进延时，低电平占下半周期
+    uint32_t next_delay = Stepper_ProfileNextDelay(motor, remain_distance);
+    uint32_t period = Stepper_StepPeriod(motor, next_delay);
+    motor->step_delay = next_delay;
+    
+    // 匀速段交给PWM输出，下一个边沿为匀速段之后第一步的上升沿
+    uint32_t span = 0;
+    if (motor->pwm_ops != NULL) {
+        span = Stepper_PwmHandoff(motor, next_delay, Stepper_CruiseSteps(motor, remain_distance));
+    }
+    return period - (period >> 1) + span;
+}
+
+/**
+ * @brief 根据曲线类型计算下一步延时
+ * @param remain_distance 剩余步数(大于0)
+ */
+static uint32_t Stepper_ProfileNextDelay(StepperMotor_t* motor, uint32_t remain_distance)
+{
+    if (motor->profile == STEPPER_PROFILE_CONST_ACCEL || motor->block_active) {
+        return Stepper_ConstAccelNextDelay(motor, remain_distance);
+    }
+    if (motor->profile == STEPPER_PROFILE_SCURVE) {
+        return Stepper_TableNextDelay(motor, remain_distance);
+    }
+    return Stepper_LinearNextDelay(motor, remain_distance);
+}
+
+/**
+ * @brief 使能步段流水线
+ */
+void Stepper_EnablePipeline(StepperMotor_t* motor, uint8_t enable)
+{
+    if (motor != NULL) {
+        motor->seg_enabled = enable ? 1 : 0;
+    }
+}
+
+/**
+ * @brief 获取步段流水线统计
+ */
+void Stepper_GetPipelineStats(StepperMotor_t* motor, StepperPipelineStats_t* stats)
+{
+    stats->depth = (uint8_t)((motor->seg_head - motor->seg_tail) & (STEPPER_SEG_RING - 1));
+    stats->depth_min = motor->seg_depth_min;
+    stats->underrun = motor->seg_underrun;
+}
+
+/**
+ * @brief 使能或关闭步进时序统计
+ */
+void Stepper_EnableTrace(StepperMotor_t* motor, uint8_t enable)
+{
+    STEPPER_ENTER_CRITICAL();
+    motor->trace_on = enable ? 1 : 0;
+    motor->trace_valid = 0;
+    if (enable) {
+        motor->trace_err_min = INT16_MAX;
+        motor->trace_err_max = INT16_MIN;
+        motor->trace_err_sum = 0;
+        motor->trace_err_span = 0;
+        motor->trace_count = 0;
+    }
+    STEPPER_EXIT_CRITICAL();
+}
+
+/**
+ * @brief 获取步进时序统计
+ */
+void Stepper_GetTraceStats(StepperMotor_t* motor, StepperTraceStats_t* stats)
+{
+    STEPPER_ENTER_CRITICAL();
+    stats->count = motor->trace_count;
+    stats->err_min = (motor->trace_count > 0) ? motor->trace_err_min : 0;
+    stats->err_max = (motor->trace_count > 0) ? motor->trace_err_max : 0;
+    stats->err_mean = (motor->trace_err_span > 0) ? 
+                      (int16_t)(motor->trace_err_sum / motor->trace_err_span) : 0;
+    STEPPER_EXIT_CRITICAL();
+}
+
+/**
+ * @brief 选择记录上升沿间隔的电机
+ */
+void Stepper_TraceCapture(StepperMotor_t* motor)
+{
+    if (motor != NULL && !motor->trace_on) {
+        Stepper_EnableTrace(motor, 1);
+    }
+    
+    STEPPER_ENTER_CRITICAL();
+    if (motor != NULL) {
+        s_trace_head = 0;
+        s_trace_count = 0;
+    }
+    s_trace_motor = motor;
+    STEPPER_EXIT_CRITICAL();
+}
+
+/**
+ * @brief 获取间隔缓冲区中的间隔数
+ */
+uint16_t Stepper_TraceCount(void)
+{
+    return s_trace_count;
+}
+
+/**
+ * @brief 读取间隔缓冲区(0为最早的间隔)
+ */
+uint16_t Stepper_TraceRead(uint16_t index)
+{
+    if (index >= s_trace_count) {
+        return 0;
+    }
+    return s_trace_ring[(s_trace_head - s_trace_count + index) & (STEPPER_TRACE_SIZE - 1)];
+}
+
+/**
+ * @brief 记录一个上升沿(边沿路径，上升沿输出之后调用)
+ * @note 时间戳: DMA输出的电机取边沿所在节拍在输出序列中的时刻，其他电机取自1us时基计数器。
+ *       规划间隔为上一步的高电平(周期的一半)加本步的低电平
+ */
+static void Stepper_TraceEdge(StepperMotor_t* motor)
+{
+    uint32_t period = motor->step_period;
+    uint32_t now;
+    
+    if (motor->dma_port != STEPPER_DMA_NONE && s_dma_words != NULL) {
+        now = s_dma_base + (s_dma_time & ~((1U << STEPPER_DMA_TICK_SHIFT) - 1));
+    } else {
+        now = bsp_GetTimeUs();
+    }
+    
+    if (motor->trace_valid) {
+        uint32_t interval = now - motor->trace_last;
+        int32_t err = (int32_t)interval - (int32_t)((motor->trace_period >> 1) + period - (period >> 1));
+        
+        if (err > INT16_MAX) {
+            err = INT16_MAX;
+        } else if (err < INT16_MIN) {
+            err = INT16_MIN;
+        }
+        if (err < motor->trace_err_min) {
+            motor->trace_err_min = (int16_t)err;
+        }
+        if (err > motor->trace_err_max) {
+            motor->trace_err_max = (int16_t)err;
+        }
+        
+        // 平均值只反映最近的间隔: 累计到统计窗口后减半
+        if (motor->trace_err_span >= STEPPER_TRACE_MEAN_SPAN) {
+            motor->trace_err_sum /= 2;
+            motor->trace_err_span /= 2;
+        }
+        motor->trace_err_sum += err;
+        motor->trace_err_span++;
+        motor->trace_count++;
+        
+        if (motor == s_trace_motor) {
+            s_trace_ring[s_trace_head] = (interval > 0xFFFF) ? 0xFFFF : (uint16_t)interval;
+            s_trace_head = (s_trace_head + 1) & (STEPPER_TRACE_SIZE - 1);
+            if (s_trace_count < STEPPER_TRACE_SIZE) {
+                s_trace_count++;
+            }
+        }
+    }
+    
+    motor->trace_last = now;
+    motor->trace_period = period;
+    motor->trace_valid = 1;
+}
+
+/**
+ * @brief 清除步段流水线统计
+ */
+void Stepper_ResetPipelineStats(StepperMotor_t* motor)
+{
+    motor->seg_underrun = 0;
+    motor->seg_depth_min = STEPPER_SEG_RING - 1;
+}
+
+/**
+ * @brief 位置运动开始时清空步段队列并预先填满
+ * @param steps 运动总步数
+ * @note 在Stepper_ProfileStart之后、启动脉冲之前调用，第一步使用曲线的起步延时
+ */
+static void Stepper_SegmentStart(StepperMotor_t* motor, uint32_t steps)
+{
+    motor->seg_active = motor->seg_enabled;
+    motor->seg_head = 0;
+    motor->seg_tail = 0;
+    motor->seg_left = 0;
+    motor->step_phase = 0;
+    Stepper_StepPeriod(motor, motor->step_delay);
+    motor->plan_remain = motor->seg_active ? steps : 0;
+    
+    Stepper_SegmentFill(motor);
+}
+
+/**
+ * @brief 按规划游标生成步段，直到队列填满或规划到终点(主循环调用)
+ * @note 每步的曲线计算在临界区内进行，防止中断同时把电机置为空闲
+ */
+static void Stepper_SegmentFill(StepperMotor_t* motor)
+{
+    uint8_t head = motor->seg_head;
+    
+    while (motor->plan_remain > 0 && ((head + 1) & (STEPPER_SEG_RING - 1)) != motor->seg_tail) {
+        StepperSegment_t* seg = &motor->seg_ring[head];
+        uint32_t first = 0, last = 0, total = 0;
+        uint16_t n = 0;
+        
+        // 匀速段整段作为一个PWM步段，规划游标直接跳到匀速段末尾
+        if (motor->pwm_ops != NULL && motor->enc_read == NULL) {
+            uint32_t cruise;
+            
+            STEPPER_ENTER_CRITICAL();
+            cruise = (motor->state == STEPPER_STATE_IDLE) ? 0 :
+                     Stepper_CruiseSteps(motor, motor->plan_remain);
+            if (cruise < STEPPER_PWM_MIN_STEPS) {
+                cruise = 0;
+            } else if (cruise > STEPPER_PWM_MAX_STEPS) {
+                cruise = STEPPER_PWM_MAX_STEPS;
+            }
+            if (cruise > 0) {
+                motor->plan_remain -= cruise;
+                motor->pwm_accel_count = motor->accel_count;
+            }
+            STEPPER_EXIT_CRITICAL();
+            
+            if (cruise > 0) {
+                seg->steps = (uint16_t)cruise;
+                seg->delay_q8 = motor->step_delay;
+                seg->delta_q8 = 0;
+                seg->pwm = 1;
+                head = (head + 1) & (STEPPER_SEG_RING - 1);
+                motor->seg_head = head;
+                continue;
+            }
+        }
+        
+        // 第一步的延时在启动时已确定，此后每规划一步得到下一步的延时
+        while (n < STEPPER_SEG_MAX_STEPS && total < (STEPPER_SEG_TIME << 8)) {
+            uint32_t delay;
+            
+            if (--motor->plan_remain == 0) {
+                break;
+            }
+            
+            STEPPER_ENTER_CRITICAL();
+            if (motor->state == STEPPER_STATE_IDLE) {
+                motor->plan_remain = 0;
+                STEPPER_EXIT_CRITICAL();
+                break;
+            }
+            delay = Stepper_ProfileNextDelay(motor, motor->plan_remain);
+            motor->step_delay = delay;
+            STEPPER_EXIT_CRITICAL();
+            
+            if (n == 0) {
+                first = delay;
+            }
+            last = delay;
+            total += delay;
+            n++;
+        }
+        
+        if (n == 0) {
+            break;
+        }
+        
+        // 段内延时按首尾线性插值
+        seg->steps = n;
+        seg->delay_q8 = first;
+        seg->delta_q8 = (n > 1) ? (int32_t)(((int64_t)last - (int64_t)first) / (n - 1)) : 0;
+        seg->pwm = 0;
+        
+        head = (head + 1) & (STEPPER_SEG_RING - 1);
+        motor->seg_head = head;
+    }
+}
+
+/**
+ * @brief 取下一步的延时(中断调用，只做加法和比较)
+ * @return 1 成功  0 队列为空
+ */
+static uint8_t Stepper_SegmentNext(StepperMotor_t* motor)
+{
+    if (motor->seg_left == 0) {
+        uint8_t tail = motor->seg_tail;
+        
+        if (tail == motor->seg_head) {
+            return 0;
+        }
+        
+        const StepperSegment_t* seg = &motor->seg_ring[tail];
+        motor->seg_left = seg->steps;
+        motor->seg_delay = seg->delay_q8;
+        motor->seg_delta = seg->delta_q8;
+        motor->seg_pwm = seg->pwm;
+        motor->seg_tail = (tail + 1) & (STEPPER_SEG_RING - 1);
+    } else {
+        motor->seg_delay += motor->seg_delta;
+    }
+    
+    motor->seg_left--;
+    Stepper_StepPeriod(motor, motor->seg_delay);
+    return 1;
+}
+
+/**
+ * @brief 计算从下一步之后还可以交给PWM输出的匀速步数
+ * @param remain 剩余步数(含下一步，下一步的延时已经算出)
+ * @return 匀速步数，这些步之后的第一步仍为匀速，0表示不在匀速段
+ * @note 匀速状态下曲线计算只在剩余步数降到减速起点时改变速度，跳过的步不影响之后的计算
+ */
+static uint32_t Stepper_CruiseSteps(const StepperMotor_t* motor, uint32_t remain)
+{
+    uint32_t start;
+    
+    if (motor->state != STEPPER_STATE_RUNNING) {
+        return 0;
+    }
+    
+    // 减速起点: 剩余步数降到start时开始减速
+    if (motor->profile == STEPPER_PROFILE_CONST_ACCEL || motor->block_active) {
+        // 运行中降低最大速度后还在降速
+        if (motor->ramp_c != motor->min_step_delay) {
+            return 0;
+        }
+        start = (motor->accel_count > motor->exit_count) ? motor->accel_count - motor->exit_count : 0;
+    } else if (motor->profile == STEPPER_PROFILE_SCURVE) {
+        start = motor->accel_count;
+    } else {
+        start = motor->accel_steps;
+    }
+    
+    return (remain > start + 1) ? remain - start - 1 : 0;
+}
+
+/**
+ * @brief 把从下一步开始的steps步交给PWM输出
+ * @param delay 步进延时(Q8，us)，下一步的步周期已由此算出
+ * @param steps 步数
+ * @return 从第一步到交出的步之后下一步的时间(us)，0表示不满足条件或PWM不能输出该周期
+ * @note 在下降沿调用，第一个脉冲在低电平半周期之后开始；位置预先计入全部步数
+ */
+static uint32_t Stepper_PwmHandoff(StepperMotor_t* motor, uint32_t delay, uint32_t steps)
+{
+    // 联动轴和跟随轴需要主轴的每个边沿，闭环时逐步比较编码器
+    if (motor->pwm_ops == NULL || motor->pwm_busy || motor->sync_next != NULL ||
+        motor->gear_list != NULL || motor->enc_read != NULL || steps < STEPPER_PWM_MIN_STEPS) {
+        return 0;
+    }
+    if (steps > STEPPER_PWM_MAX_STEPS) {
+        steps = STEPPER_PWM_MAX_STEPS;
+    }
+    
+    uint32_t lead = Stepper_EdgeLead(motor->step_period - (motor->step_period >> 1));
+    uint32_t span = motor->pwm_ops->start(motor, lead, delay, steps);
+    
+    if (span == 0) {
+        return 0;
+    }
+    
+    motor->pwm_busy = 1;
+    motor->pwm_period = delay;
+    motor->trace_valid = 0;
+    motor->position += (motor->dir == STEPPER_DIR_CW) ? steps : -steps;
+    return span;
+}
+
+/**
+ * @brief 截短PWM输出的匀速段，规划游标退回到截短处(停止和重新规划前调用)
+ * @note 正在输出时在安全余量之后截短，边沿路径的下一个边沿同样提前；
+ *       流水线中还没有开始的PWM步段连同之后的步段一起丢弃。
+ *       两种情况都把曲线状态恢复为生成PWM步段时的匀速状态
+ */
+static void Stepper_PwmCut(StepperMotor_t* motor)
+{
+    uint32_t period = 0;
+    
+    if (motor->pwm_ops == NULL) {
+        return;
+    }
+    
+    STEPPER_ENTER_CRITICAL();
+    if (motor->pwm_busy) {
+        uint32_t early = 0;
+        uint32_t removed = motor->pwm_ops->cut(motor, &early);
+        
+        if (removed > 0) {
+            motor->position += (motor->dir == STEPPER_DIR_CW) ? -removed : removed;
+            Stepper_PwmRetime(motor, early);
+            if (motor->seg_active) {
+                motor->seg_head = motor->seg_tail;
+                motor->seg_left = 0;
+                period = motor->pwm_period;
+                
+                // 规划游标在PWM的最后一步
+                motor->plan_remain = ((motor->dir == STEPPER_DIR_CW) ? 
+                                      motor->target_position - motor->position : 
+                                      motor->position - motor->target_position) + 1;
+            }
+        }
+    }
+    
+    if (period == 0 && motor->seg_active) {
+        uint8_t i = motor->seg_tail;
+        
+        while (i != motor->seg_head && !motor->seg_ring[i].pwm) {
+            i = (i + 1) & (STEPPER_SEG_RING - 1);
+        }
+        if (i != motor->seg_head) {
+            period = motor->seg_ring[i].delay_q8;
+            for (uint8_t j = i; j != motor->seg_head; j = (j + 1) & (STEPPER_SEG_RING - 1)) {
+                motor->plan_remain += motor->seg_ring[j].steps;
+            }
+            motor->seg_head = i;
+        }
+    }
+    
+    if (period > 0 && motor->state != STEPPER_STATE_IDLE) {
+        motor->state = STEPPER_STATE_RUNNING;
+        motor->accel_count = motor->pwm_accel_count;
+        motor->step_delay = period;
+        motor->ramp_c = period;
+    }
+    STEPPER_EXIT_CRITICAL();
+}
+
+/**
+ * @brief PWM输出被截短后把电机的下一个边沿提前
+ * @param early 提前的时间(us)
+ */
+static void Stepper_PwmRetime(StepperMotor_t* motor, uint32_t early)
+{
+    if (motor->dma_port != STEPPER_DMA_NONE) {
+        motor->dma_next -= early;
+        return;
+    }
+    
+    if (motor->timer_channel == STEPPER_CHANNEL_NONE) {
+        motor->edge_delay -= early;
+        return;
+    }
+    
+    // 到下一个边沿的剩余时间 = 当前比较点 + 分段等待
+    __IO uint32_t* ccr = &STEPPER_TIM->CCR1 + motor->timer_channel;
+    uint32_t left = (uint16_t)(*ccr - STEPPER_TIM->CNT) + motor->wait_ticks;
+    
+    left = (left > early + STEPPER_TIM_MIN_EDGE) ? left - early : STEPPER_TIM_MIN_EDGE;
+    if (left > STEPPER_TIM_MAX_WAIT) {
+        motor->wait_ticks = left - STEPPER_TIM_MAX_WAIT;
+        left = STEPPER_TIM_MAX_WAIT;
+    } else {
+        motor->wait_ticks = 0;
+    }
+    *ccr = (uint16_t)(STEPPER_TIM->CNT + left);
+}
+
+/**
+ * @brief 从现在到当前边沿之后delay的时间
+ * @note DMA缓冲区填充中按缓冲区时间换算，比较中断扣除中断响应已经过的时间
+ */
+static uint32_t Stepper_EdgeLead(uint32_t delay)
+{
+    if (s_dma_words != NULL) {
+        return s_dma_lead + s_dma_time + delay;
+    }
+    return (delay > s_edge_lag) ? delay - s_edge_lag : 0;
+}
+
+/**
+ * @brief 由步进延时得到本步的步周期，小数部分累加到下一步
+ * @param delay 步进延时(Q8，us)
+ * @return 步周期(us)
+ */
+static uint32_t Stepper_StepPeriod(StepperMotor_t* motor, uint32_t delay)
+{
+    uint32_t t = delay + motor->step_phase;
+    
+    motor->step_phase = (uint8_t)t;
+    motor->step_period = t >> 8;
+    return motor->step_period;
+}
+
+/**
+ * @brief 启动运动段队列的第一段
+ */
+void Stepper_StartBlock(const StepperBlock_t* block, StepperBlockFunc_t func, void* ctx)
+{
+    StepperMotor_t* master;
+    
+    if (block == NULL || block->axis_count == 0 || block->axis_count > STEPPER_LINEAR_MAX_AXES) {
+        return;
+    }
+    
+    // 停止各轴并解除之前的联动关系
+    for (uint8_t i = 0; i < block->axis_count; i++) {
+        StepperMotor_t* axis = block->axes[i];
+        
+        Stepper_Disarm(axis);
+        Stepper_SyncRelease(axis->sync_master != NULL ? axis->sync_master : axis);
+        axis->block_func = NULL;
+        axis->retarget_pending = 0;
+        if (axis->gear_master != NULL) {
+            Stepper_GearDetach(axis);
+        }
+        axis->pulse_state = 0;
+        Stepper_PinWrite(axis, PIN_TYPE_PWM, 0);
+        Stepper_Enable(axis, 1);
+    }
+    
+    master = Stepper_BlockSetup(block);
+    master->seg_active = 0;
+    master->block_func = func;
+    master->block_ctx = ctx;
+    master->step_phase = 0;
+    Stepper_StepPeriod(master, master->step_delay);
+    Stepper_Start(master);
+}
+
+/**
+ * @brief 按运动段设置各轴方向、目标和联动关系，主轴装载恒加速度递推参数
+ * @return 主轴
+ * @note 主循环和比较中断都会调用，不做除法
+ */
+static StepperMotor_t* Stepper_BlockSetup(const StepperBlock_t* block)
+{
+    StepperMotor_t* master = block->axes[block->major];
+    uint32_t major_steps = block->steps[block->major];
+    
+    for (uint8_t i = 0; i < block->axis_count; i++) {
+        block->axes[i]->sync_master = NULL;
+        block->axes[i]->sync_next = NULL;
+    }
+    
+    for (uint8_t i = 0; i < block->axis_count; i++) {
+        StepperMotor_t* axis = block->axes[i];
+        
+        if (axis->dir != (StepperDirection_t)block->dir[i]) {
+            Stepper_SetDirection(axis, (StepperDirection_t)block->dir[i]);
+        }
+        axis->target_position = block->target[i];
+        
+        // 补偿段: 之前的补偿计入累计值，本段各步从当前位置起不计入对外的位置
+        if (block->backlash && block->steps[i] > 0) {
+            axis->backlash_offset = Stepper_BacklashSteps(axis);
+            axis->backlash_from = axis->position;
+            axis->backlash_pending = (block->dir[i] == STEPPER_DIR_CW) ? 
+                                     (int32_t)block->steps[i] : -(int32_t)block->steps[i];
+        }
+        
+        if (axis == master) {
+            continue;
+        }
+        
+        // 本段不动的轴停止输出，其余轴挂到主轴上
+        if (block->steps[i] == 0) {
+            axis->state = STEPPER_STATE_IDLE;
+            continue;
+        }
+        axis->dda_num = block->steps[i];
+        axis->dda_den = major_steps;
+        axis->dda_err = major_steps >> 1;
+        axis->state = STEPPER_STATE_RUNNING;
+        axis->sync_master = master;
+        axis->sync_next = master->sync_next;
+        master->sync_next = axis;
+    }
+    
+    // 递推序号取绝对值(accel_n0为0)，进入、退出速度可以不同
+    master->block_active = 1;
+    master->accel_n0 = 0;
+    master->accel_count = block->entry_n;
+    master->exit_count = block->exit_n;
+    master->accel_steps = block->max_n;
+    master->ramp_c = block->entry_c;
+    master->step_delay = block->entry_c;
+    master->min_step_delay = block->min_delay;
+    master->max_step_delay = block->exit_delay;
+    master->state = (block->entry_n < block->max_n) ? 
+                    STEPPER_STATE_ACCELERATING : STEPPER_STATE_RUNNING;
+    
+    return master;
+}
+
+/**
+ * @brief 当前段到位后衔接下一段(在主轴的脉冲下降沿调用)
+ * @param motor 当前段的主轴
+ * @return 当前主轴到下一个边沿的延时，主轴已更换时返回0
+ */
+static uint32_t Stepper_BlockChain(StepperMotor_t* motor, const StepperBlock_t* block)
+{
+    StepperMotor_t* master = Stepper_BlockSetup(block);
+    uint32_t period = Stepper_StepPeriod(master, master->step_delay);
+    uint32_t delay = period - (period >> 1);
+    
+    if (master == motor) {
+        // 换向的DIR还未输出时暂停，由主循环在DIR生效后继续
+        if (!Stepper_IoReady(master)) {
+            master->io_wait = 1;
+        }
+        return delay;
+    }
+    
+    // 主轴更换: 回调交给新的主轴，从当前时刻起预约新主轴的第一个边沿
+    master->seg_active = 0;
+    master->block_func = motor->block_func;
+    master->block_ctx = motor->block_ctx;
+    motor->block_func = NULL;
+    Stepper_ArmAfter(master, delay);
+    return 0;
+}
+
+/**
+ * @brief 从当前时刻起经过delay后产生电机的第一个边沿
+ * @note 用于启动运动和运动段衔接时更换主轴，电机已使能且脉冲为低电平
+ */
+static void Stepper_ArmAfter(StepperMotor_t* motor, uint32_t delay)
+{
+    motor->pulse_state = 0;
+    motor->wait_ticks = 0;
+    motor->trace_valid = 0;
+    
+    // DIR/EN还未到达引脚，由Stepper_ProcessAllMotors在生效后预约
+    if (!Stepper_IoReady(motor)) {
+        motor->io_wait = 1;
+        return;
+    }
+    motor->io_wait = 0;
+    
+    // DMA输出: 从当前边沿时刻起算(不在缓冲区填充中时从下一个半缓冲区起点起算)
+    if (motor->dma_port != STEPPER_DMA_NONE) {
+        motor->dma_next = (s_dma_words != NULL ? s_dma_time : 0) + delay;
+        motor->dma_run = 1;
+        return;
+    }
+    
+    if (motor->timer_channel == STEPPER_CHANNEL_NONE) {
+        motor->last_step_time = bsp_GetTimeUs();
+        motor->edge_delay = delay;
+        return;
+    }
+    
+    if (delay > STEPPER_TIM_MAX_WAIT) {
+        motor->wait_ticks = delay - STEPPER_TIM_MAX_WAIT;
+        delay = STEPPER_TIM_MAX_WAIT;
+    }
+    
+    uint32_t it = TIM_IT_CC1 << motor->timer_channel;
+    __IO uint32_t* ccr = &STEPPER_TIM->CCR1 + motor->timer_channel;
+    
+    STEPPER_ENTER_CRITICAL();
+    *ccr = (uint16_t)(STEPPER_TIM->CNT + delay);
+    STEPPER_TIM->SR = (uint16_t)~it;
+    STEPPER_TIM->DIER |= it;
+    STEPPER_EXIT_CRITICAL();
+}
+
+/**
+ * @brief 检查电机及其从动轴的限位开关，触发时停止整组运动
+ * @return 1 限位触发
+ */
+static uint8_t Stepper_SyncLimit(StepperMotor_t* motor)
+{
+    uint8_t triggered = 0;
+    
+    for (StepperMotor_t* axis = motor; axis != NULL; axis = axis->sync_next) {
+        if (!axis->limit_enabled) {
+            continue;
+        }
+        
+        if ((axis->dir == STEPPER_DIR_CW) ? axis->cw_limit : axis->ccw_limit) {
+            triggered = 1;
+            
+            // 如果是回归零点操作，重置位置
+            if (axis->dir == STEPPER_DIR_CCW && axis->ccw_limit) {
+                axis->position = 0;
+                axis->target_position = 0;
+                Stepper_Rebase(axis);
+            }
+        }
+    }
+    
+    // 跟随轴限位时停止主轴(龙门双驱等场合两侧同时停止)
+    for (StepperMotor_t* axis = motor->gear_list; axis != NULL; axis = axis->gear_next) {
+        if (axis->limit_enabled && ((axis->dir == STEPPER_DIR_CW) ? axis->cw_limit : axis->ccw_limit)) {
+            triggered = 1;
+        }
+    }
+    
+    if (triggered) {
+        motor->state = STEPPER_STATE_IDLE;
+    }
+    return triggered;
+}
+
+/**
+ * @brief 主轴运动结束，解除从动轴联动
+ * @note 中断和主循环都会调用，从动轴没有定时器通道，只需恢复引脚和状态
+ */
+static void Stepper_SyncRelease(StepperMotor_t* motor)
+{
+    StepperMotor_t* axis = motor->sync_next;
+    
+    motor->sync_next = NULL;
+    while (axis != NULL) {
+        StepperMotor_t* next = axis->sync_next;
+        
+        if (axis->pulse_state) {
+            Stepper_PulseOut(axis, 0);
+        }
+        axis->pulse_state = 0;
+        axis->state = STEPPER_STATE_IDLE;
+        axis->sync_master = NULL;
+        axis->sync_next = NULL;
+        axis = next;
+    }
+}
+
+/**
+ * @brief 主轴产生一个边沿时带动跟随轴
+ * @param level 1 上升沿(按误差累加决定跟随轴本步是否输出)  0 下降沿(完成一步)
+ * @note 在主轴输出边沿的同一处调用，每个跟随轴只做一次加法和比较
+ */
+static void Stepper_GearEdge(StepperMotor_t* motor, uint8_t level)
+{
+    for (StepperMotor_t* gear = motor->gear_list; gear != NULL; gear = gear->gear_next) {
+        if (level) {
+            gear->gear_err += gear->gear_num;
+            if (gear->gear_err >= gear->gear_den) {
+                gear->gear_err -= gear->gear_den;
+                Stepper_PulseOut(gear, 1);
+                gear->pulse_state = 1;
+                Stepper_GearEdge(gear, 1);
+            }
+        } else if (gear->pulse_state) {
+            Stepper_PulseOut(gear, 0);
+            gear->pulse_state = 0;
+            gear->position += (gear->dir == STEPPER_DIR_CW) ? 1 : -1;
+            Stepper_GearEdge(gear, 0);
+        }
+    }
+}
+
+/**
+ * @brief 电子齿轮: 跟随轴按固定比例跟随主轴的步
+ */
+uint8_t Stepper_GearAttach(StepperMotor_t* follower, StepperMotor_t* master,
+                           uint16_t num, uint16_t den, uint8_t reverse)
+{
+    if (follower == NULL || master == NULL || den == 0 || num == 0 || num > den) {
+        return 0;
+    }
+    
+    // 不能挂到自身或自己的跟随轴上
+    for (StepperMotor_t* axis = master; axis != NULL; axis = axis->gear_master) {
+        if (axis == follower) {
+            return 0;
+        }
+    }
+    
+    // 跟随轴停止独立运动
+    Stepper_Stop(follower, 1);
+    Stepper_GearDetach(follower);
+    
+    follower->gear_num = num;
+    follower->gear_den = den;
+    follower->gear_err = den >> 1;  // 误差初值取半步使步数分布居中
+    follower->gear_reverse = reverse ? 1 : 0;
+    follower->pulse_state = 0;
+    Stepper_PinWrite(follower, PIN_TYPE_PWM, 0);
+    Stepper_Enable(follower, 1);
+    
+    STEPPER_ENTER_CRITICAL();
+    follower->gear_master = master;
+    follower->gear_next = master->gear_list;
+    master->gear_list = follower;
+    STEPPER_EXIT_CRITICAL();
+    
+    // 方向与主轴一致(主轴运行中换向时同样会带动跟随轴)
+    StepperDirection_t dir = follower->gear_reverse ? 
+                             ((master->dir == STEPPER_DIR_CW) ? STEPPER_DIR_CCW : STEPPER_DIR_CW) : master->dir;
+    Stepper_SetDirection(follower, dir);
+    return 1;
+}
+
+/**
+ * @brief 解除电子齿轮跟随
+ */
+void Stepper_GearDetach(StepperMotor_t* follower)
+{
+    StepperMotor_t* master = follower->gear_master;
+    
+    if (master == NULL) {
+        return;
+    }
+    
+    STEPPER_ENTER_CRITICAL();
+    StepperMotor_t** link = &master->gear_list;
+    while (*link != NULL && *link != follower) {
+        link = &(*link)->gear_next;
+    }
+    if (*link == follower) {
+        *link = follower->gear_next;
+    }
+    follower->gear_master = NULL;
+    follower->gear_next = NULL;
+    if (follower->pulse_state) {
+        Stepper_PulseOut(follower, 0);
+        follower->pulse_state = 0;
+    }
+    STEPPER_EXIT_CRITICAL();
+}
+
+/**
+ * @brief 线性曲线：根据状态更新速度并返回下一步延时
+ * @param remain_distance 剩余步数(大于0)
+ */
+static uint32_t Stepper_LinearNextDelay(StepperMotor_t* motor, uint32_t remain_distance)
+{
+    uint32_t next_delay = motor->step_delay; // 默认保持当前延时
+    
+    // 根据状态更新速度
+    switch (motor->state) {
+        case STEPPER_STATE_ACCELERATING:
+        {
+            // 使用电机结构体存储加速步数，而不是静态变量
+            motor->accel_count++;
+            
+            if (motor->accel_count < motor->accel_steps) {
+                // 查表插值，避免每步做除法
+                next_delay = Stepper_RampDelay(motor, motor->accel_count);
+                
+                // 确保不小于最小延时
+                if (next_delay < motor->min_step_delay) {
+                    next_delay = motor->min_step_delay;
+                }
+                
+                // 提前进入减速阶段
+                if (remain_distance <= motor->accel_steps) {
+                    motor->state = STEPPER_STATE_DECELERATING;
                     motor->accel_count = 0;
                 }
             } else {
@@ -321,12 +2100,8 @@ void Stepper_Handler(StepperMotor_t* motor)
         
         case STEPPER_STATE_DECELERATING:
             if (remain_distance > 0 && motor->accel_steps > 0) {
-                // 优化减速计算
-                uint32_t decel_factor = (motor->accel_steps > remain_distance) ? 
-                                      (motor->accel_steps - remain_distance) : 0;
-                
-                next_delay = motor->min_step_delay + 
-                    ((motor->max_step_delay - motor->min_step_delay) * decel_factor) / motor->accel_steps;
+                // 减速与加速对称，按剩余步数查表
+                next_delay = Stepper_RampDelay(motor, remain_distance);
                 
                 // 确保不大于最大延时
                 if (next_delay > motor->max_step_delay) {
@@ -341,8 +2116,320 @@ void Stepper_Handler(StepperMotor_t* motor)
             break;
     }
     
-    // 更新步进延时
-    motor->step_delay = next_delay;
+    return next_delay;
+}
+
+/**
+ * @brief 恒加速度曲线：Austin整数递推计算下一步延时
+ * @param remain_distance 剩余步数(大于0)
+ * @note accel_count为离开启动速度的步数，递推序号 n = accel_n0 + accel_count；
+ *       减速是加速的逆递推 c(n-1) = c(n) + 2c(n)/(4n-1)，剩余步数等于accel_count时开始
+ */
+static uint32_t Stepper_ConstAccelNextDelay(StepperMotor_t* motor, uint32_t remain_distance)
+{
+    uint32_t c = motor->ramp_c;
+    uint32_t min_c = motor->min_step_delay;
+    uint32_t max_c = motor->max_step_delay;
+    uint32_t n;
+    
+    // 剩余距离只够减速到退出速度(独立运动为启动速度)时开始减速
+    if (motor->state != STEPPER_STATE_DECELERATING && 
+        remain_distance + motor->exit_count <= motor->accel_count) {
+        motor->state = STEPPER_STATE_DECELERATING;
+    }
+    
+    switch (motor->state) {
+        case STEPPER_STATE_ACCELERATING:
+            motor->accel_count++;
+            n = motor->accel_n0 + motor->accel_count;
+            c -= (2 * c) / (4 * n + 1);
+            
+            // 到达最大速度，进入匀速
+            if (motor->accel_count >= motor->accel_steps || c <= min_c) {
+                c = min_c;
+                motor->state = STEPPER_STATE_RUNNING;
+            }
+            break;
+        
+        case STEPPER_STATE_DECELERATING:
+            if (motor->accel_count > motor->exit_count) {
+                n = motor->accel_n0 + motor->accel_count;
+                c += (2 * c) / (4 * n - 1);
+                motor->accel_count--;
+            }
+            if (c > max_c) {
+                c = max_c;
+            }
+            break;
+        
+        case STEPPER_STATE_RUNNING:
+            // 运行中降低了最大速度: 按减速递推降到新的匀速速度
+            if (c < min_c && motor->accel_count > 0) {
+                n = motor->accel_n0 + motor->accel_count;
+                c += (2 * c) / (4 * n - 1);
+                motor->accel_count--;
+                if (c > min_c) {
+                    c = min_c;
+                }
+            }
+            break;
+        
+        default:
+            break;
+    }
+    
+    motor->ramp_c = c;
+    return c;
+}
+
+/**
+ * @brief S曲线：按已加速步数查表得到下一步延时
+ * @param remain_distance 剩余步数(大于0)
+ * @note 与恒加速度曲线相同，剩余步数等于accel_count时开始对称减速
+ */
+static uint32_t Stepper_TableNextDelay(StepperMotor_t* motor, uint32_t remain_distance)
+{
+    if (motor->state != STEPPER_STATE_DECELERATING && remain_distance <= motor->accel_count) {
+        motor->state = STEPPER_STATE_DECELERATING;
+    }
+    
+    switch (motor->state) {
+        case STEPPER_STATE_ACCELERATING:
+            motor->accel_count++;
+            if (motor->accel_count >= motor->accel_steps) {
+                motor->state = STEPPER_STATE_RUNNING;
+            }
+            break;
+        
+        case STEPPER_STATE_DECELERATING:
+            if (motor->accel_count > 0) {
+                motor->accel_count--;
+            }
+            break;
+        
+        default:
+            break;
+    }
+    
+    return Stepper_RampDelay(motor, motor->accel_count);
+}
+
+// S曲线加速段时间参数(时间单位us)
+typedef struct {
+    uint32_t vs;    // 起始速度(步/秒)
+    uint32_t vmax;  // 终止速度(步/秒)
+    uint32_t jerk;  // 加加速度(步/秒^3)
+    uint32_t ap;    // 实际达到的最大加速度(步/秒^2)
+    uint64_t tj;    // 加加速度段时长
+    uint64_t ta;    // 匀加速段时长
+    uint64_t t;     // 加速段总时长
+} StepperSCurve_t;
+
+/**
+ * @brief 计算从启动速度加速到vmax的S曲线时间参数
+ * @note 速度差足够时为 加加速-匀加速-减加速 三段，否则只有两段且加速度达不到设定值
+ */
+static void Stepper_SCurveTiming(const StepperMotor_t* motor, uint32_t vmax, StepperSCurve_t* sc)
+{
+    uint32_t vs = (motor->start_speed < vmax) ? motor->start_speed : vmax;
+    uint32_t dv = vmax - vs;
+    uint32_t a = motor->accel;
+    uint32_t j = motor->jerk;
+    
+    sc->vs = vs;
+    sc->vmax = vmax;
+    sc->jerk = j;
+    
+    if (j == 0 || (uint64_t)a * a <= (uint64_t)dv * j) {
+        // 能达到设定加速度: tj = a/j, ta = dv/a - tj
+        sc->ap = a;
+        sc->tj = (j > 0) ? ((uint64_t)a * 1000000) / j : 0;
+        sc->ta = ((uint64_t)dv * 1000000) / a - sc->tj;
+    } else {
+        // 达不到设定加速度: tj = sqrt(dv/j)
+        sc->tj = Stepper_Sqrt(((uint64_t)dv * 1000000000000ULL) / j);
+        sc->ap = (uint32_t)(((uint64_t)j * sc->tj) / 1000000);
+        sc->ta = 0;
+    }
+    sc->t = 2 * sc->tj + sc->ta;
+}
+
+/**
+ * @brief S曲线在t时刻的速度
+ * @param t 从加速开始的时间(us)
+ * @return 速度(Q8，步/秒)
+ */
+static uint32_t Stepper_SCurveVelocity(const StepperSCurve_t* sc, uint64_t t)
+{
+    uint64_t u;
+    
+    if (t < sc->tj) {
+        // 加加速段: v = vs + j*t^2/2
+        u = (((uint64_t)sc->jerk * t << 8) / 1000000) * t / 2000000;
+        return (sc->vs << 8) + (uint32_t)u;
+    }
+    
+    if (t < sc->tj + sc->ta) {
+        // 匀加速段: v = v1 + ap*(t-tj)，v1 = vs + ap*tj/2
+        u = ((uint64_t)sc->ap * (sc->tj + 2 * (t - sc->tj)) << 8) / 2000000;
+        return (sc->vs << 8) + (uint32_t)u;
+    }
+    
+    // 减加速段与加加速段对称: v = vmax - j*(T-t)^2/2
+    t = (t < sc->t) ? (sc->t - t) : 0;
+    u = (((uint64_t)sc->jerk * t << 8) / 1000000) * t / 2000000;
+    return (sc->vmax << 8) - (uint32_t)u;
+}
+
+/**
+ * @brief S曲线从启动速度加速到vmax所需的步数
+ */
+static uint32_t Stepper_SCurveDistance(const StepperMotor_t* motor, uint32_t vmax)
+{
+    StepperSCurve_t sc;
+    
+    Stepper_SCurveTiming(motor, vmax, &sc);
+    
+    // 速度曲线关于中点对称，距离 = 平均速度 * 时间
+    return (uint32_t)(((uint64_t)(sc.vs + sc.vmax) * sc.t) / 2000000);
+}
+
+/**
+ * @brief 生成S曲线延时表
+ * @param vmax 加速终止速度(步/秒)
+ * @note 按时间等分积分出位置，再在表的等分步数点上插值速度并换算为延时，
+ *       只在设置参数或启动短距离运动时执行
+ */
+static void Stepper_BuildSCurveTable(StepperMotor_t* motor, uint32_t vmax)
+{
+    const uint32_t samples = 64;
+    StepperSCurve_t sc;
+    uint64_t total_q8, target_q8, s_q8 = 0, s_prev_q8 = 0;
+    uint32_t v, v_prev, i = 1;
+    
+    Stepper_SCurveTiming(motor, vmax, &sc);
+    total_q8 = ((uint64_t)(sc.vs + sc.vmax) * sc.t << 8) / 2000000;
+    
+    motor->ramp_vmax = vmax;
+    motor->accel_steps = (uint32_t)(total_q8 >> 8);
+    motor->ramp_table[0] = motor->max_step_delay;
+    v_prev = sc.vs << 8;
+    target_q8 = total_q8 / STEPPER_RAMP_SEGMENTS;
+    
+    for (uint32_t n = 1; n <= samples && i < STEPPER_RAMP_SEGMENTS; n++) {
+        uint64_t dt = sc.t / samples;
+        
+        v = Stepper_SCurveVelocity(&sc, dt * n);
+        s_q8 += ((uint64_t)(v_prev + v) * dt) / 2000000;
+        
+        // 本时间段内经过的表格点，按位置线性插值速度
+        while (i < STEPPER_RAMP_SEGMENTS && s_q8 >= target_q8) {
+            uint32_t vi = v_prev;
+            if (s_q8 > s_prev_q8) {
+                vi += (uint32_t)(((uint64_t)(v - v_prev) * (target_q8 - s_prev_q8)) / (s_q8 - s_prev_q8));
+            }
+            motor->ramp_table[i] = (vi > 0) ? (uint32_t)(65536000000ULL / vi) : motor->max_step_delay;
+            i++;
+            target_q8 = total_q8 * i / STEPPER_RAMP_SEGMENTS;
+        }
+        
+        s_prev_q8 = s_q8;
+        v_prev = v;
+    }
+    
+    // 积分截断误差导致未填满的点和终点取终止速度
+    for (; i <= STEPPER_RAMP_SEGMENTS; i++) {
+        motor->ramp_table[i] = Stepper_SpeedDelay(motor, vmax);
+    }
+    
+    motor->ramp_scale = (motor->accel_steps > 0) ? 
+                        (((uint32_t)STEPPER_RAMP_SEGMENTS << 24) + motor->accel_steps - 1) / motor->accel_steps : 0;
+}
+
+/**
+ * @brief 按曲线类型设置运动起始速度和状态
+ * @param steps 本次运动总步数
+ */
+static void Stepper_ProfileStart(StepperMotor_t* motor, uint32_t steps)
+{
+    // 运动段改写过速度参数，先按设置值恢复
+    if (motor->block_active) {
+        motor->block_active = 0;
+        Stepper_PrepareProfile(motor);
+    }
+    
+    motor->block_func = NULL;
+    motor->accel_count = 0;
+    motor->exit_count = 0;
+    
+    if (motor->profile == STEPPER_PROFILE_CONST_ACCEL) {
+        motor->ramp_c = motor->ramp_c0;
+        motor->step_delay = motor->ramp_c;
+        
+        // 短距离运动由剩余步数判断自动提前减速，不需要整段加速
+        motor->state = (motor->accel_steps > 0 && steps > 1) ? 
+                       STEPPER_STATE_ACCELERATING : STEPPER_STATE_RUNNING;
+        return;
+    }
+    
+    if (motor->profile == STEPPER_PROFILE_SCURVE && motor->accel > 0) {
+        uint32_t vmax = motor->max_speed;
+        
+        // 距离不够完整加减速时，二分查找能在一半距离内加速到的最高速度
+        if (2 * (uint64_t)Stepper_SCurveDistance(motor, vmax) > steps) {
+            uint32_t lo = motor->start_speed, hi = vmax;
+            while (lo + 1 < hi) {
+                uint32_t mid = lo + (hi - lo) / 2;
+                if (2 * (uint64_t)Stepper_SCurveDistance(motor, mid) <= steps) {
+                    lo = mid;
+                } else {
+                    hi = mid;
+                }
+            }
+            vmax = lo;
+        }
+        if (vmax != motor->ramp_vmax) {
+            Stepper_BuildSCurveTable(motor, vmax);
+        }
+        
+        motor->step_delay = motor->ramp_table[0];
+        motor->state = (motor->accel_steps > 0 && steps > 1) ? 
+                       STEPPER_STATE_ACCELERATING : STEPPER_STATE_RUNNING;
+        return;
+    }
+    
+    // 设置初始速度为启动速度
+    motor->step_delay = motor->max_step_delay;
+    
+    // 更新电机状态
+    if (motor->accel_steps > 0 && steps > motor->accel_steps * 2) {
+        motor->state = STEPPER_STATE_ACCELERATING;
+    } else {
+        motor->state = STEPPER_STATE_RUNNING;
+    }
+}
+
+/**
+ * @brief 整数平方根(向下取整)
+ */
+uint32_t Stepper_Sqrt(uint64_t x)
+{
+    uint64_t res = 0;
+    uint64_t bit = 1ULL << 62;
+    
+    while (bit > x) {
+        bit >>= 2;
+    }
+    while (bit != 0) {
+        if (x >= res + bit) {
+            x -= res + bit;
+            res = (res >> 1) + bit;
+        } else {
+            res >>= 1;
+        }
+        bit >>= 2;
+    }
+    return (uint32_t)res;
 }
 
 /**
@@ -358,7 +2445,58 @@ StepperState_t Stepper_GetState(StepperMotor_t* motor)
  */
 uint32_t Stepper_GetPosition(StepperMotor_t* motor)
 {
-    return motor->position;
+    uint32_t position;
+    
+    // 补偿段起点和位置在比较中断中更新，一起读取
+    STEPPER_ENTER_CRITICAL();
+    position = motor->position - (uint32_t)Stepper_BacklashSteps(motor);
+    STEPPER_EXIT_CRITICAL();
+    return position;
+}
+
+/**
+ * @brief 设置反向间隙
+ */
+void Stepper_SetBacklash(StepperMotor_t* motor, uint16_t steps)
+{
+    motor->backlash = steps;
+}
+
+/**
+ * @brief 累计的补偿步数(正转为正): 最近一个补偿段按已走过的步数计算，不超过该段步数
+ */
+static int32_t Stepper_BacklashSteps(const StepperMotor_t* motor)
+{
+    int32_t done = (int32_t)(motor->position - motor->backlash_from);
+    
+    if (motor->backlash_pending >= 0) {
+        done = (done < 0) ? 0 : (done > motor->backlash_pending) ? motor->backlash_pending : done;
+    } else {
+        done = (done > 0) ? 0 : (done < motor->backlash_pending) ? motor->backlash_pending : done;
+    }
+    return motor->backlash_offset + done;
+}
+
+/**
+ * @brief 位置计数重新设定后按间隙所在的一侧设定补偿步数，编码器位置同步为新的位置计数
+ * @note 补偿步数正转后为间隙、反转后为0，position不小于对外的位置，正转后的position加上间隙
+ */
+static void Stepper_Rebase(StepperMotor_t* motor)
+{
+    motor->backlash_pending = 0;
+    motor->backlash_from = motor->position;
+    motor->backlash_offset = (motor->dir == STEPPER_DIR_CW) ? motor->backlash : 0;
+    motor->position += (uint32_t)motor->backlash_offset;
+    motor->target_position = motor->position;
+    Stepper_EncoderSync(motor);
+}
+
+/**
+ * @brief 获取按工程单位表示的当前位置
+ */
+int32_t Stepper_GetPositionUnits(StepperMotor_t* motor)
+{
+    return Stepper_StepsToUnits(motor, (int32_t)Stepper_GetPosition(motor));
 }
 
 /**
@@ -368,6 +2506,203 @@ void Stepper_ResetPosition(StepperMotor_t* motor)
 {
     motor->position = 0;
     motor->target_position = 0;
+    Stepper_Rebase(motor);
+}
+
+/**
+ * @brief 挂接编码器，使能闭环
+ */
+void Stepper_AttachEncoder(StepperMotor_t* motor, StepperEncoderFunc_t read, int32_t steps_per_count,
+                           uint16_t window, uint16_t stall)
+{
+    if (motor == NULL) {
+        return;
+    }
+    
+    motor->enc_read = read;
+    motor->enc_scale = steps_per_count;
+    motor->enc_window = window;
+    motor->enc_stall = (stall > window) ? stall : window;
+    motor->enc_corrected = 0;
+    motor->enc_corrections = 0;
+    Stepper_EncoderSync(motor);
+}
+
+/**
+ * @brief 把编码器位置同步为当前位置计数
+ */
+void Stepper_EncoderSync(StepperMotor_t* motor)
+{
+    STEPPER_ENTER_CRITICAL();
+    if (motor->enc_read != NULL) {
+        motor->enc_last = motor->enc_read(motor);
+    }
+    motor->enc_frac = 0x8000;  // 换算结果四舍五入
+    motor->enc_position = motor->position;
+    motor->enc_error = 0;
+    motor->enc_error_max = 0;
+    motor->enc_mark = motor->position;
+    motor->enc_slip = 0;
+    motor->enc_idle = 0;
+    motor->enc_retry = 0;
+    motor->enc_fault = STEPPER_ENC_OK;
+    STEPPER_EXIT_CRITICAL();
+}
+
+/**
+ * @brief 获取编码器闭环统计
+ */
+void Stepper_GetEncoderStats(StepperMotor_t* motor, StepperEncoderStats_t* stats)
+{
+    STEPPER_ENTER_CRITICAL();
+    stats->position = motor->enc_position;
+    stats->error = motor->enc_error;
+    stats->error_max = motor->enc_error_max;
+    stats->corrected = motor->enc_corrected;
+    stats->corrections = motor->enc_corrections;
+    stats->fault = motor->enc_fault;
+    STEPPER_EXIT_CRITICAL();
+}
+
+/**
+ * @brief 读编码器计数器，累计换算的步数并计算跟随误差(边沿路径和主循环调用)
+ * @note 计数器增量按16位有符号数处理，乘以每计数步数后与小数部分一起累加，只做乘法和移位
+ */
+static void Stepper_EncoderSample(StepperMotor_t* motor)
+{
+    uint16_t count = motor->enc_read(motor);
+    int32_t q = (int16_t)(count - motor->enc_last) * motor->enc_scale + motor->enc_frac;
+    int32_t error;
+    
+    motor->enc_last = count;
+    motor->enc_frac = (uint16_t)q;
+    motor->enc_position += (uint32_t)(q >> 16);
+    
+    error = (int32_t)(motor->enc_position - motor->position);
+    motor->enc_error = error;
+    if ((error < 0 ? -error : error) >
+        (motor->enc_error_max < 0 ? -motor->enc_error_max : motor->enc_error_max)) {
+        motor->enc_error_max = error;
+    }
+}
+
+/**
+ * @brief 位置计数改为编码器位置(主循环调用)
+ * @param extra 沿运动方向少走的步数(负数为多走)
+ * @note 运行中剩余步数相应增减(流水线同时移动规划游标)，多走时不超过剩余距离；停止时目标同时改为编码器位置
+ */
+static void Stepper_EncoderCorrect(StepperMotor_t* motor, int32_t extra)
+{
+    STEPPER_ENTER_CRITICAL();
+    if (motor->state != STEPPER_STATE_IDLE) {
+        uint32_t remain = (motor->dir == STEPPER_DIR_CW) ? motor->target_position - motor->position :
+                                                           motor->position - motor->target_position;
+        
+        if (extra < 0 && (uint32_t)-extra > remain) {
+            extra = -(int32_t)remain;
+        }
+        if (motor->seg_active) {
+            // 规划完毕时最后一步的延时已在队列中，游标从下一步开始
+            if (extra > 0) {
+                motor->plan_remain += (uint32_t)extra + (motor->plan_remain == 0);
+            } else {
+                motor->plan_remain -= ((uint32_t)-extra < motor->plan_remain) ? (uint32_t)-extra :
+                                                                                motor->plan_remain;
+            }
+        }
+    } else {
+        motor->target_position = motor->enc_position;
+    }
+    motor->position -= (motor->dir == STEPPER_DIR_CW) ? (uint32_t)extra : (uint32_t)-extra;
+    motor->enc_error = (int32_t)(motor->enc_position - motor->position);
+    STEPPER_EXIT_CRITICAL();
+    
+    motor->enc_corrected += (uint32_t)((extra < 0) ? -extra : extra);
+    motor->enc_corrections++;
+}
+
+/**
+ * @brief 编码器闭环处理(主循环调用)
+ * @note 滞后为沿运动方向少走的步数。运行中超过补步窗口时把位置改为编码器位置并延长剩余步数，
+ *       仍在原目标处停止；超过堵转阈值时立即停止。停止稳定后仍超差时运动回原位置
+ */
+static void Stepper_EncoderPoll(StepperMotor_t* motor)
+{
+    uint32_t lead = 0;
+    int32_t lag;
+    
+    STEPPER_ENTER_CRITICAL();
+    if (motor->state == STEPPER_STATE_IDLE || motor->dma_port != STEPPER_DMA_NONE) {
+        Stepper_EncoderSample(motor);
+    }
+    lag = (motor->dir == STEPPER_DIR_CW) ? -motor->enc_error : motor->enc_error;
+    STEPPER_EXIT_CRITICAL();
+    
+    if (motor->enc_fault != STEPPER_ENC_OK) {
+        return;
+    }
+    
+    if (motor->state != STEPPER_STATE_IDLE) {
+        int32_t ahead = (int32_t)(motor->enc_position - motor->enc_mark);
+        
+        motor->enc_idle = 0;
+        
+        // 编码器沿运动方向前进过，之前的补步不算堵转
+        if ((motor->dir == STEPPER_DIR_CW) ? (ahead > 0) : (ahead < 0)) {
+            motor->enc_mark = motor->enc_position;
+            motor->enc_slip = 0;
+        }
+        
+        // DMA输出的位置超前引脚，超前时间内的步数不算滞后
+        if (motor->dma_port != STEPPER_DMA_NONE && motor->step_period > 0) {
+            lead = STEPPER_ENC_DMA_LEAD_US / motor->step_period + 1;
+        }
+        
+        if (lag + (int32_t)motor->enc_slip > (int32_t)(lead + motor->enc_stall) ||
+            lag < -(int32_t)motor->enc_stall) {
+            // 堵转: 立即停止(联动轴整组停止)，位置改为编码器位置
+            Stepper_Stop(motor, 1);
+            Stepper_EncoderCorrect(motor, lag);
+            motor->enc_fault = STEPPER_ENC_STALL;
+        } else if ((lag > (int32_t)(lead + motor->enc_window) || lag < -(int32_t)motor->enc_window) &&
+                   motor->sync_master == NULL && motor->sync_next == NULL &&
+                   motor->gear_master == NULL && motor->gear_list == NULL) {
+            lag = (lag > 0) ? lag - (int32_t)lead : lag;
+            Stepper_EncoderCorrect(motor, lag);
+            if (lag > 0) {
+                motor->enc_slip += (uint32_t)lag;
+            }
+        }
+        return;
+    }
+    
+    // 停止后等待机械和DMA缓冲区中的脉冲稳定，跟随轴的位置由主轴决定
+    motor->enc_mark = motor->enc_position;
+    motor->enc_slip = 0;
+    if (!motor->enc_idle) {
+        motor->enc_idle = 1;
+        motor->enc_idle_time = bsp_GetTimeUs();
+        return;
+    }
+    if (bsp_GetTimeUs() - motor->enc_idle_time < STEPPER_ENC_SETTLE_US ||
+        motor->retarget_pending || motor->gear_master != NULL) {
+        return;
+    }
+    if (lag <= (int32_t)motor->enc_window && lag >= -(int32_t)motor->enc_window) {
+        motor->enc_retry = 0;
+        return;
+    }
+    
+    // 补步次数用完仍超差: 位置改为编码器位置，不再补步
+    uint32_t target = motor->position;
+    Stepper_EncoderCorrect(motor, lag);
+    if (motor->enc_retry >= STEPPER_ENC_RETRY) {
+        motor->enc_fault = STEPPER_ENC_LOST;
+        return;
+    }
+    motor->enc_retry++;
+    motor->enc_idle = 0;
+    Stepper_MoveTo(motor, target);
 }
 
 /**
@@ -375,13 +2710,48 @@ void Stepper_ResetPosition(StepperMotor_t* motor)
  */
 void Stepper_ProcessAllMotors(void)
 {
-    StepperMotor_t* motor = g_stepper_list;
+    StepperMotor_t* motor;
+    
+    // 填充步段流水线，DIR/EN生效后启动等待中的电机
+    for (motor = g_stepper_list; motor != NULL; motor = motor->next) {
+        if (motor->io_wait && motor->state != STEPPER_STATE_IDLE && motor->sync_master == NULL) {
+            Stepper_ArmAfter(motor, STEPPER_TIM_START_DELAY);
+        }
+        // PWM输出期间边沿路径不检查限位，轮询到的限位在这里停止
+        if (motor->pwm_busy && motor->limit_enabled &&
+            ((motor->dir == STEPPER_DIR_CW) ? motor->cw_limit : motor->ccw_limit)) {
+            Stepper_LimitEvent(motor, motor->dir, 1);
+        }
+        if (motor->enc_read != NULL) {
+            Stepper_EncoderPoll(motor);
+        }
+        if (motor->retarget_pending && motor->state == STEPPER_STATE_IDLE) {
+            if (motor->retarget_pending == STEPPER_RETARGET_JOG) {
+                Stepper_Jog(motor, motor->jog_speed);
+            } else {
+                Stepper_MoveTo(motor, motor->retarget);
+            }
+        }
+        if (motor->seg_active && motor->state != STEPPER_STATE_IDLE && motor->sync_master == NULL) {
+            uint8_t depth = (uint8_t)((motor->seg_head - motor->seg_tail) & (STEPPER_SEG_RING - 1));
+            if (depth < motor->seg_depth_min && motor->plan_remain > 0) {
+                motor->seg_depth_min = depth;
+            }
+            Stepper_SegmentFill(motor);
+        }
+    }
     
-    // 遍历所有电机并处理
-    while (motor != NULL) {
-        Stepper_Handler(motor);
-        motor = motor->next;
+    // 处理轮询方式的电机，本次到期的边沿合并输出
+    StepperPulseBatch_t batch;
+    batch.count = 0;
+    s_pulse_batch = &batch;
+    for (motor = g_stepper_list; motor != NULL; motor = motor->next) {
+        if (motor->timer_channel == STEPPER_CHANNEL_NONE) {
+            Stepper_Handler(motor);
+        }
     }
+    s_pulse_batch = NULL;
+    Stepper_BatchFlush(&batch);
 }
 
 /**
@@ -443,8 +2813,15 @@ static void Stepper_SetDirection(StepperMotor_t* motor, StepperDirection_t dir)
     motor->dir = dir;
     
     // 设置方向引脚
-    if (motor->PinControl != NULL) {
-        motor->PinControl(PIN_TYPE_DIR, (dir == STEPPER_DIR_CW) ? 0 : 1);
+    Stepper_PinWrite(motor, PIN_TYPE_DIR, (dir == STEPPER_DIR_CW) ? 0 : 1);
+    
+    // 跟随轴随主轴换向
+    for (StepperMotor_t* gear = motor->gear_list; gear != NULL; gear = gear->gear_next) {
+        StepperDirection_t gear_dir = gear->gear_reverse ? 
+                                      ((dir == STEPPER_DIR_CW) ? STEPPER_DIR_CCW : STEPPER_DIR_CW) : dir;
+        if (gear->dir != gear_dir) {
+            Stepper_SetDirection(gear, gear_dir);
+        }
     }
 }
 
@@ -454,14 +2831,338 @@ static void Stepper_SetDirection(StepperMotor_t* motor, StepperDirection_t dir)
  */
 static void Stepper_TogglePulse(StepperMotor_t* motor)
 {
+    if (motor->pulse_state == 0) {
+        Stepper_PinWrite(motor, PIN_TYPE_PWM, 1);  // PWM引脚高电平
+        motor->pulse_state = 1;
+    } else {
+        Stepper_PinWrite(motor, PIN_TYPE_PWM, 0);  // PWM引脚低电平
+        motor->pulse_state = 0;
+    }
+}
+
+/**
+ * @brief 启动脉冲输出
+ * @note 从低电平开始，定时器方式下在STEPPER_TIM_START_DELAY后产生第一个边沿
+ */
+static void Stepper_Start(StepperMotor_t* motor)
+{
+    // 重要：重置脉冲状态，确保从低电平开始
+    motor->pulse_state = 0;
+    motor->edge_delay = 0;
+    motor->wait_ticks = 0;
+    Stepper_PinWrite(motor, PIN_TYPE_PWM, 0);
+    
+    // 上次运动被中途停止时跟随轴可能停在高电平
+    for (StepperMotor_t* gear = motor->gear_list; gear != NULL; gear = gear->gear_next) {
+        if (gear->pulse_state) {
+            gear->pulse_state = 0;
+            Stepper_PinWrite(gear, PIN_TYPE_PWM, 0);
+        }
+    }
+    
+    // 使能电机
+    Stepper_Enable(motor, 1);
+    
+    // 预约第一个边沿(DIR/EN还在扩展输出映像中时推迟到生效后)
+    Stepper_ArmAfter(motor, STEPPER_TIM_START_DELAY);
+}
+
+/**
+ * @brief 关闭电机的比较通道中断或DMA输出(轮询方式的电机无操作)
+ */
+static void Stepper_Disarm(StepperMotor_t* motor)
+{
+    motor->dma_run = 0;
+    
+    // PWM还没有输出的步已计入位置，撤销后扣除
+    if (motor->pwm_busy) {
+        STEPPER_ENTER_CRITICAL();
+        if (motor->pwm_busy) {
+            uint32_t undone = motor->pwm_ops->cancel(motor);
+            motor->position += (motor->dir == STEPPER_DIR_CW) ? -undone : undone;
+            motor->pwm_busy = 0;
+            if (motor->state == STEPPER_STATE_IDLE) {
+                motor->target_position = motor->position;
+            }
+        }
+        STEPPER_EXIT_CRITICAL();
+    }
+    
+    if (motor->timer_channel == STEPPER_CHANNEL_NONE) {
+        return;
+    }
+    
+    uint32_t it = TIM_IT_CC1 << motor->timer_channel;
+    
+    STEPPER_ENTER_CRITICAL();
+    STEPPER_TIM->DIER &= ~it;
+    STEPPER_TIM->SR = (uint16_t)~it;
+    STEPPER_EXIT_CRITICAL();
+}
+
+/**
+ * @brief 比较通道事件处理：产生边沿并预约下一个比较点
+ * @param ch 比较通道(0~3)
+ */
+static void Stepper_ChannelEvent(uint8_t ch)
+{
+    StepperMotor_t* motor = s_channel_motor[ch];
+    __IO uint32_t* ccr = &STEPPER_TIM->CCR1 + ch;
+    uint32_t delay;
+    
+    // 已被主循环停止
+    if (motor->state == STEPPER_STATE_IDLE) {
+        STEPPER_TIM->DIER &= ~(TIM_IT_CC1 << ch);
+        return;
+    }
+    
+    if (motor->wait_ticks == 0) {
+        s_edge_lag = (uint16_t)(STEPPER_TIM->CNT - *ccr);
+        delay = Stepper_Edge(motor);
+        s_edge_lag = 0;
+        
+        // 运动结束(到位、限位或被停止)、定时已交给新的主轴或等待换向，关闭通道
+        if (motor->state == STEPPER_STATE_IDLE || motor->sync_master != NULL || motor->io_wait) {
+            STEPPER_TIM->DIER &= ~(TIM_IT_CC1 << ch);
+            return;
+        }
+    } else {
+        delay = motor->wait_ticks;
+    }
+    
+    // 16位计数器单次最多等待STEPPER_TIM_MAX_WAIT，超过则分段
+    if (delay > STEPPER_TIM_MAX_WAIT) {
+        motor->wait_ticks = delay - STEPPER_TIM_MAX_WAIT;
+        delay = STEPPER_TIM_MAX_WAIT;
+    } else {
+        motor->wait_ticks = 0;
+        if (delay < STEPPER_TIM_MIN_EDGE) {
+            delay = STEPPER_TIM_MIN_EDGE;
+        }
+    }
+    
+    // 基于上一个比较点累加，避免中断延迟造成累计误差；已错过则尽快补发
+    uint16_t next = (uint16_t)(*ccr + delay);
+    uint16_t now = (uint16_t)STEPPER_TIM->CNT;
+    if ((uint16_t)(next - now) > delay) {
+        next = now + STEPPER_TIM_MIN_EDGE;
+    }
+    *ccr = next;
+}
+
+/**
+ * @brief 步进脉冲引擎比较中断处理函数
+ */
+void TIM1_CC_IRQHandler(void)
+{
+    uint32_t status = STEPPER_TIM->SR & STEPPER_TIM->DIER &
+                      (TIM_IT_CC1 | TIM_IT_CC2 | TIM_IT_CC3 | TIM_IT_CC4);
+    
+    STEPPER_TIM->SR = (uint16_t)~status;
+    
+    // 同时到期的通道合并输出(中断可能打断主循环的批量输出，退出前恢复)
+    StepperPulseBatch_t batch;
+    StepperPulseBatch_t* prev = s_pulse_batch;
+    batch.count = 0;
+    s_pulse_batch = &batch;
+    
+    for (uint8_t ch = 0; ch < STEPPER_TIM_CHANNELS; ch++) {
+        if ((status & (TIM_IT_CC1 << ch)) && s_channel_motor[ch] != NULL) {
+            Stepper_ChannelEvent(ch);
+        }
+    }
+    
+    s_pulse_batch = prev;
+    Stepper_BatchFlush(&batch);
+}
+
+/**
+ * @brief 把电机的STEP脉冲交给DMA脉冲序列输出
+ */
+void Stepper_AttachDma(StepperMotor_t* motor, uint8_t port, uint16_t pin)
+{
+    if (motor == NULL || (port != STEPPER_DMA_NONE && port >= STEPPER_DMA_PORTS)) {
+        return;
+    }
+    
+    Stepper_Disarm(motor);
+    
+    STEPPER_ENTER_CRITICAL();
+    motor->dma_port = port;
+    motor->dma_pin = pin;
+    motor->dma_next = 0;
+    STEPPER_EXIT_CRITICAL();
+    
+    // DMA输出的电机释放比较通道，恢复时重新分配
+    for (uint8_t ch = 0; ch < STEPPER_TIM_CHANNELS; ch++) {
+        if (port != STEPPER_DMA_NONE && s_channel_motor[ch] == motor) {
+            s_channel_motor[ch] = NULL;
+            motor->timer_channel = STEPPER_CHANNEL_NONE;
+        } else if (port == STEPPER_DMA_NONE && s_timer_ready && s_channel_motor[ch] == NULL &&
+                   motor->timer_channel == STEPPER_CHANNEL_NONE) {
+            s_channel_motor[ch] = motor;
+            motor->timer_channel = ch;
+        }
+    }
+}
+
+/**
+ * @brief 把电机的匀速段交给硬件PWM输出
+ */
+void Stepper_AttachPwm(StepperMotor_t* motor, const StepperPwmOps_t* ops)
+{
+    if (motor == NULL) {
+        return;
+    }
+    
+    Stepper_Disarm(motor);
+    motor->pwm_ops = ops;
+}
+
+/**
+ * @brief PWM输出完成
+ */
+void Stepper_PwmDone(StepperMotor_t* motor)
+{
+    motor->pwm_busy = 0;
+}
+
+/**
+ * @brief 生成半个DMA缓冲区的脉冲序列
+ */
+void Stepper_DmaRender(uint32_t* const words[], uint16_t ticks, uint32_t lead)
+{
+    uint32_t span = (uint32_t)ticks << STEPPER_DMA_TICK_SHIFT;
+    StepperMotor_t* motor;
+    uint8_t busy;
+    
+    for (uint8_t port = 0; port < STEPPER_DMA_PORTS; port++) {
+        for (uint16_t i = 0; i < ticks; i++) {
+            words[port][i] = 0;
+        }
+    }
+    
+    // 停止的电机在起点补一个复位，保证停止时已写入缓冲区的高电平被拉低(跟随轴脉冲中间除外)
+    for (motor = g_stepper_list; motor != NULL; motor = motor->next) {
+        if (motor->dma_port != STEPPER_DMA_NONE && !motor->dma_run && motor->sync_master == NULL &&
+            !(motor->gear_master != NULL && motor->pulse_state)) {
+            words[motor->dma_port][0] |= (uint32_t)motor->dma_pin << 16;
+        }
+    }
+    
+    // 逐个电机写入本段时间内的边沿；衔接时被启动的新主轴在下一轮补写
+    s_dma_words = words;
+    s_dma_lead = lead;
+    do {
+        busy = 0;
+        for (motor = g_stepper_list; motor != NULL; motor = motor->next) {
+            if (motor->dma_port == STEPPER_DMA_NONE || !motor->dma_run || motor->dma_next >= span) {
+                continue;
+            }
+            busy = 1;
+            
+            while (motor->dma_next < span) {
+                s_dma_time = motor->dma_next;
+                uint32_t delay = Stepper_Edge(motor);
+                
+                // 运动结束、定时已交给新的主轴或等待换向
+                if (motor->state == STEPPER_STATE_IDLE || motor->sync_master != NULL || motor->io_wait) {
+                    motor->dma_run = 0;
+                    break;
+                }
+                
+                // 同一节拍内的置位和复位会被置位覆盖，边沿至少间隔一个节拍
+                if (delay < (1U << STEPPER_DMA_TICK_SHIFT)) {
+                    delay = 1U << STEPPER_DMA_TICK_SHIFT;
+                }
+                motor->dma_next += delay;
+            }
+        }
+    } while (busy);
+    s_dma_words = NULL;
+    s_dma_base += span;
+    
+    for (motor = g_stepper_list; motor != NULL; motor = motor->next) {
+        if (motor->dma_run) {
+            motor->dma_next -= span;
+        }
+    }
+}
+
+/**
+ * @brief 输出STEP引脚电平(边沿路径)
+ * @note DMA输出的电机在缓冲区填充中写入当前节拍的BSRR置位/复位位；
+ *       使用引脚描述的电机直接写BSRR，批量输出打开时先合并到批量中
+ */
+static void Stepper_PulseOut(StepperMotor_t* motor, uint8_t level)
+{
+    const StepperPinDesc_t* pins = motor->pins;
+    
+    if (motor->dma_port != STEPPER_DMA_NONE && s_dma_words != NULL) {
+        uint32_t bit = level ? motor->dma_pin : ((uint32_t)motor->dma_pin << 16);
+        s_dma_words[motor->dma_port][s_dma_time >> STEPPER_DMA_TICK_SHIFT] |= bit;
+        return;
+    }
+    
+    if (pins != NULL) {
+        uint32_t bit = level ? pins->step_pin : ((uint32_t)pins->step_pin << 16);
+        StepperPulseBatch_t* batch = s_pulse_batch;
+        
+        if (batch != NULL) {
+            for (uint8_t i = 0; i < batch->count; i++) {
+                if (batch->port[i] == pins->step_port) {
+                    batch->bsrr[i] |= bit;
+                    return;
+                }
+            }
+            if (batch->count < STEPPER_BATCH_PORTS) {
+                batch->port[batch->count] = pins->step_port;
+                batch->bsrr[batch->count] = bit;
+                batch->count++;
+                return;
+            }
+        }
+        pins->step_port->BSRR = bit;
+        return;
+    }
+    
     if (motor->PinControl != NULL) {
-        if (motor->pulse_state == 0) {
-            motor->PinControl(PIN_TYPE_PWM, 1);  // PWM引脚高电平
-            motor->pulse_state = 1;
-        } else {
-            motor->PinControl(PIN_TYPE_PWM, 0);  // PWM引脚低电平
-            motor->pulse_state = 0;
+        motor->PinControl(PIN_TYPE_PWM, level);
+    }
+}
+
+/**
+ * @brief 输出合并后的STEP边沿，每个端口写一次BSRR
+ */
+static void Stepper_BatchFlush(const StepperPulseBatch_t* batch)
+{
+    for (uint8_t i = 0; i < batch->count; i++) {
+        batch->port[i]->BSRR = batch->bsrr[i];
+    }
+}
+
+/**
+ * @brief 写电机引脚(启停、换向等非边沿路径)
+ */
+static void Stepper_PinWrite(StepperMotor_t* motor, StepperPinType_t type, uint8_t level)
+{
+    const StepperPinDesc_t* pins = motor->pins;
+    
+    if (type == PIN_TYPE_DIR) {
+        level ^= motor->dir_invert;
+    }
+    if (pins == NULL) {
+        if (motor->PinControl != NULL) {
+            motor->PinControl(type, level);
         }
+        return;
+    }
+    
+    if (type == PIN_TYPE_PWM) {
+        pins->step_port->BSRR = level ? pins->step_pin : ((uint32_t)pins->step_pin << 16);
+    } else if (s_expander_write != NULL) {
+        motor->io_seq = s_expander_write((type == PIN_TYPE_DIR) ? pins->dir_bit : pins->en_bit, level);
+        motor->io_pending = 1;
     }
 }
 
@@ -476,26 +3177,95 @@ void Stepper_RunSpeed(StepperMotor_t* motor, int32_t speed)
         return;
     }
     
+    // 单独运动联动轴时先停止整组插补，跟随轴解除电子齿轮
+    if (motor->sync_master != NULL || motor->sync_next != NULL) {
+        Stepper_Stop(motor, 1);
+    }
+    if (motor->gear_master != NULL) {
+        Stepper_GearDetach(motor);
+    }
+    
+    // 停止正在输出的脉冲
+    Stepper_Disarm(motor);
+    motor->retarget_pending = 0;
+    
     // 设置方向
     StepperDirection_t dir = (speed > 0) ? STEPPER_DIR_CW : STEPPER_DIR_CCW;
     Stepper_SetDirection(motor, dir);
     
-    // 计算步进延时(微秒)
-    uint32_t step_delay = 1000000 / abs(speed); // 将步/秒转换为微秒延时
+    // 计算步进延时(Q8，us)
+    uint32_t step_delay = Stepper_SpeedDelay(motor, (uint32_t)abs(speed));
     
-    // 设置电机参数
+    // 设置电机参数，按恒加速度递推的匀速状态保持该速度(速度参数被改写，下次独立运动前恢复)
     motor->step_delay = step_delay;
+    motor->min_step_delay = step_delay;
+    motor->ramp_c = step_delay;
+    motor->step_phase = 0;
+    Stepper_StepPeriod(motor, step_delay);
+    motor->accel_n0 = 0;
+    motor->accel_count = 0;
+    motor->exit_count = 0;
+    motor->block_active = 1;
     motor->target_position = (dir == STEPPER_DIR_CW) ? 0xFFFFFFFF : 0; // 设置极端值使电机持续运行
+    motor->seg_active = 0;
     motor->state = STEPPER_STATE_RUNNING; // 设置为匀速运行状态
     
-    // 重置脉冲状态
-    motor->pulse_state = 0;
-    if (motor->PinControl != NULL) {
-        motor->PinControl(PIN_TYPE_PWM, 0);
+    // 使能电机并启动脉冲输出
+    Stepper_Start(motor);
+}
+
+/**
+ * @brief 速度模式: 按加速度从当前速度变化到指定速度
+ */
+void Stepper_Jog(StepperMotor_t* motor, int32_t speed)
+{
+    StepperDirection_t dir = (speed > 0) ? STEPPER_DIR_CW : STEPPER_DIR_CCW;
+    uint32_t v = (uint32_t)abs(speed);
+    
+    // 不加减速时等同于匀速运动
+    if (motor->accel == 0) {
+        Stepper_RunSpeed(motor, speed);
+        return;
     }
     
-    // 使能电机
-    Stepper_Enable(motor, 1);
+    // 单独运动联动轴时先停止整组插补
+    if (motor->sync_master != NULL || motor->sync_next != NULL) {
+        Stepper_Stop(motor, 1);
+    }
+    
+    motor->retarget_pending = 0;
+    if (v == 0) {
+        Stepper_Stop(motor, 0);
+        return;
+    }
+    if (v > motor->max_speed) {
+        v = motor->max_speed;
+    }
+    
+    if (motor->state != STEPPER_STATE_IDLE) {
+        if (motor->dir == dir) {
+            // 同方向: 从当前速度加速或减速到新速度，不停止
+            motor->block_func = NULL;
+            if (Stepper_Replan(motor, (dir == STEPPER_DIR_CW) ? 0xFFFFFFFF : 0, v, 0) != 2) {
+                return;
+            }
+        } else {
+            // 反方向: 先减速停止，停止后由Stepper_ProcessAllMotors反向加速
+            Stepper_Stop(motor, 0);
+            if (motor->state != STEPPER_STATE_IDLE) {
+                motor->jog_speed = speed;
+                motor->retarget_pending = STEPPER_RETARGET_JOG;
+                return;
+            }
+        }
+    }
+    
+    // 从静止以启动速度起步，再按恒加速度递推加速到目标速度
+    uint32_t vs = (motor->start_speed < v) ? motor->start_speed : v;
+    Stepper_RunSpeed(motor, (dir == STEPPER_DIR_CW) ? (int32_t)vs : -(int32_t)vs);
+    if (vs < v) {
+        Stepper_Replan(motor, motor->target_position, v, 0);
+    }
 }
 
 /**
@@ -525,6 +3295,103 @@ void Stepper_EnableLimitSwitches(StepperMotor_t* motor, uint8_t enable)
     motor->limit_enabled = enable ? 1 : 0;
 }
 
+/**
+ * @brief 注册DMA脉冲序列的边沿撤销函数
+ */
+void Stepper_SetDmaCancel(StepperDmaCancelFunc_t func)
+{
+    s_dma_cancel = func;
+}
+
+/**
+ * @brief 立即停止一个轴的脉冲输出，位置修正为引脚上实际输出的步数
+ * @note 比较中断/轮询方式上升沿已输出时补下降沿并计入这一步；
+ *       DMA方式撤销缓冲区中还没有输出的边沿，扣除已计入位置的步数
+ */
+static void Stepper_HaltAxis(StepperMotor_t* axis)
+{
+    int16_t undone = 0;
+    
+    if (axis->dma_port != STEPPER_DMA_NONE && s_dma_cancel != NULL) {
+        undone = s_dma_cancel(axis->dma_port, axis->dma_pin);
+    } else if (axis->pulse_state == 1) {
+        Stepper_PulseOut(axis, 0);
+        undone = -1;
+    }
+    axis->pulse_state = 0;
+    axis->position -= (axis->dir == STEPPER_DIR_CW) ? undone : -undone;
+    
+    for (StepperMotor_t* gear = axis->gear_list; gear != NULL; gear = gear->gear_next) {
+        Stepper_HaltAxis(gear);
+    }
+}
+
+/**
+ * @brief 限位开关电平变化(限位输入中断中调用)
+ */
+void Stepper_LimitEvent(StepperMotor_t* motor, StepperDirection_t side, uint8_t active)
+{
+    StepperMotor_t* master = motor;
+    
+    if (side == STEPPER_DIR_CW) {
+        motor->cw_limit = active ? 1 : 0;
+    } else {
+        motor->ccw_limit = active ? 1 : 0;
+    }
+    
+    if (!active || !motor->limit_enabled || motor->dir != side) {
+        return;
+    }
+    
+    // 脉冲由插补主轴或电子齿轮的主轴产生，停止整组运动
+    while (master->sync_master != NULL || master->gear_master != NULL) {
+        master = (master->sync_master != NULL) ? master->sync_master : master->gear_master;
+    }
+    
+    STEPPER_ENTER_CRITICAL();
+    if (master->state != STEPPER_STATE_IDLE) {
+        master->state = STEPPER_STATE_IDLE;
+        master->block_func = NULL;
+        master->retarget_pending = 0;
+        Stepper_Disarm(master);
+        
+        for (StepperMotor_t* axis = master; axis != NULL; axis = axis->sync_next) {
+            Stepper_HaltAxis(axis);
+        }
+        Stepper_SyncRelease(master);
+        master->target_position = master->position;
+        master->plan_remain = 0;
+        
+        motor->latch_position = motor->position;
+        motor->latch_valid = 1;
+        
+        // 与轮询限位相同，反转限位作为原点
+        if (side == STEPPER_DIR_CCW) {
+            motor->position = 0;
+            motor->target_position = 0;
+            Stepper_Rebase(motor);
+        }
+    }
+    STEPPER_EXIT_CRITICAL();
+}
+
+/**
+ * @brief 读取限位中断锁存的位置
+ */
+uint8_t Stepper_GetLatch(StepperMotor_t* motor, uint32_t* position)
+{
+    uint8_t valid;
+    
+    STEPPER_ENTER_CRITICAL();
+    valid = motor->latch_valid;
+    if (valid) {
+        *position = motor->latch_position;
+        motor->latch_valid = 0;
+    }
+    STEPPER_EXIT_CRITICAL();
+    return valid;
+}
+
 /**
  * @brief 回归零点（寻找原点）
  */
@@ -2,8 +2,66 @@
 #define __BSP_MOTOR_H
 
 #include "py32f0xx_hal.h"
+#include "bsp_timebase.h"
 #include <stdint.h>
 
+// 步进脉冲引擎定时器配置(1MHz计数，每个比较通道独立驱动一个电机)
+#define STEPPER_TIM                 TIM1
+#define STEPPER_TIM_CLK_ENABLE()    __HAL_RCC_TIM1_CLK_ENABLE()
+#define STEPPER_TIM_CC_IRQn         TIM1_CC_IRQn
+#define STEPPER_TIM_CHANNELS        4       // 可用比较通道数(最多4个电机由硬件定时)
+#define STEPPER_TIM_MAX_WAIT        0x8000  // 单次比较最长等待(us)，更长的延时分段等待
+#define STEPPER_TIM_MIN_EDGE        2       // 两个边沿之间最短间隔(us)
+#define STEPPER_TIM_START_DELAY     10      // 启动运动到第一个边沿的延时(us)
+#define STEPPER_CHANNEL_NONE        0xFF    // 未分配比较通道(由主循环轮询)
+#define STEPPER_IO_SETUP_US         5       // 扩展输出的DIR/EN到达引脚后到第一个STEP边沿的建立时间(us)
+
+// 直线插补最多联动轴数
+#define STEPPER_LINEAR_MAX_AXES     4
+
+// 步段流水线: 主循环预先计算步段，比较中断只做加法和比较
+#define STEPPER_SEG_RING            8       // 步段环形队列长度(2的幂，实际可用长度少1)
+#define STEPPER_SEG_TIME            1000    // 每个步段的目标时长(us)
+#define STEPPER_SEG_MAX_STEPS       64      // 每个步段最多步数
+#define STEPPER_SEG_RETRY           50      // 步段欠载时重试间隔(us)
+
+// DMA脉冲序列: 定时器每个节拍触发DMA向GPIO的BSRR写一个字，缓冲区分两半轮流填充
+#define STEPPER_DMA_TICK_SHIFT      1       // 节拍为(1<<STEPPER_DMA_TICK_SHIFT)us
+#define STEPPER_DMA_HALF            64      // 半缓冲区的节拍数
+#define STEPPER_DMA_PORTS           2       // 输出端口数(每个端口一个DMA通道)
+#define STEPPER_DMA_PORT_A          0       // GPIOA
+#define STEPPER_DMA_PORT_B          1       // GPIOB
+#define STEPPER_DMA_NONE            0xFF    // 不使用DMA输出
+
+// 匀速段硬件PWM输出: 匀速段整段交给定时器PWM输出，边沿路径跳过这些步
+#define STEPPER_PWM_MIN_STEPS       64      // 匀速段不少于此步数才交给PWM输出
+#define STEPPER_PWM_MAX_STEPS       0xFFFF  // 一次交给PWM输出的最多步数(更长的匀速段分多次)
+
+// 步进时序跟踪: 记录上升沿间隔与规划间隔的误差，选中的一个电机的间隔写入环形缓冲区
+#define STEPPER_TRACE_SIZE          256     // 间隔缓冲区长度(2的幂，每项2字节)
+#define STEPPER_TRACE_MEAN_SPAN     1024    // 平均误差的统计窗口(步数，到达后累计值减半)
+
+// 停止后待执行的运动(运行中改目标或速度模式反向时先减速停止)
+#define STEPPER_RETARGET_MOVE       1       // 运动到retarget
+#define STEPPER_RETARGET_JOG        2       // 速度模式加速到jog_speed
+
+// 加减速延时表分段数(表长度为分段数+1，段内线性插值)
+#define STEPPER_RAMP_SEGMENTS       16
+
+// 步进延时为Q8(1/256us)，边沿按整数us输出，小数部分逐步累加(相位累加)，平均步周期等于设定延时
+#define STEPPER_DELAY_MAX_Q8        0xFFFF0000UL    // 最长步进延时(约16.7秒，对应约0.06步/秒)
+
+// 工程单位换算
+#define STEPPER_MICROSTEP_MAX       256     // 最大细分数
+
+// 编码器闭环: 按步采样编码器，跟随误差超过窗口时补步，超过堵转阈值时停止
+#define STEPPER_ENC_SETTLE_US       2000    // 停止后经过此时间(us)再比较，仍超差时补步运动到原位置
+#define STEPPER_ENC_RETRY           3       // 停止后连续补步的最多次数，仍超差时判为丢步
+#define STEPPER_ENC_DMA_LEAD_US     ((2 * STEPPER_DMA_HALF) << STEPPER_DMA_TICK_SHIFT) // DMA输出的位置超前引脚的最长时间
+#define STEPPER_ENC_OK              0       // 无故障
+#define STEPPER_ENC_STALL           1       // 运行中跟随误差超过堵转阈值，已停止
+#define STEPPER_ENC_LOST            2       // 停止后补步STEPPER_ENC_RETRY次仍超差
+
 // 步进电机状态定义
 typedef enum {
     STEPPER_STATE_IDLE = 0,     // 空闲状态
@@ -19,6 +77,13 @@ typedef enum {
     STEPPER_DIR_CCW = 1  // 逆时针
 } StepperDirection_t;
 
+// 加减速曲线类型定义
+typedef enum {
+    STEPPER_PROFILE_LINEAR = 0,      // 延时随步数线性变化(查表插值)
+    STEPPER_PROFILE_CONST_ACCEL = 1, // 恒加速度(Austin整数递推)
+    STEPPER_PROFILE_SCURVE = 2       // S曲线(7段，加加速度受限，查表插值)
+} StepperProfile_t;
+
 // 引脚类型定义
 typedef enum {
     PIN_TYPE_PWM = 0,    // PWM引脚
@@ -26,13 +91,91 @@ typedef enum {
     PIN_TYPE_EN = 2      // 使能引脚
 } StepperPinType_t;
 
+// 步段: 连续steps步，第一步延时delay_q8，之后每步增加delta_q8(Q8，us)
+typedef struct {
+    uint32_t delay_q8;         // 第一步延时
+    int32_t delta_q8;          // 每步延时增量
+    uint16_t steps;            // 步数
+    uint8_t pwm;               // 匀速段，交给PWM输出(PWM忙时按普通步段输出)
+} StepperSegment_t;
+
+// 步段流水线统计(用于确定队列长度)
+typedef struct {
+    uint8_t depth;             // 当前队列中的步段数
+    uint8_t depth_min;         // 运行中观察到的最小步段数
+    uint32_t underrun;         // 欠载次数(队列空时中断等待)
+} StepperPipelineStats_t;
+
+// 步进时序统计(误差 = 实际上升沿间隔 - 规划间隔，us)
+typedef struct {
+    int16_t err_min;           // 最小误差
+    int16_t err_max;           // 最大误差
+    int16_t err_mean;          // 平均误差(最近约STEPPER_TRACE_MEAN_SPAN步)
+    uint32_t count;            // 统计的间隔数
+} StepperTraceStats_t;
+
+// 编码器闭环统计(跟随误差 = 编码器位置 - 位置计数，步)
+typedef struct {
+    uint32_t position;         // 编码器换算的位置(与position同一坐标)
+    int32_t error;             // 最近一次采样的跟随误差
+    int32_t error_max;         // 绝对值最大的跟随误差
+    uint32_t corrected;        // 累计补步数
+    uint16_t corrections;      // 补步次数
+    uint8_t fault;             // 故障(STEPPER_ENC_x)
+} StepperEncoderStats_t;
+
+// 速度参数(原样保存和恢复，保留小数速度)
+typedef struct {
+    uint32_t max_speed;        // 最大速度(步/秒，取整)
+    uint32_t start_speed;      // 启动速度(步/秒，取整)
+    uint32_t speed_delay;      // 匀速延时(Q8，us)
+    uint32_t start_delay;      // 启动延时(Q8，us)
+    uint32_t accel;            // 加速度(步/秒^2)
+} StepperSpeed_t;
+
 // 引脚控制回调函数类型定义
 typedef void (*PinControlFunc_t)(StepperPinType_t pinType, uint8_t state);
 
+// 引脚描述: STEP直接写GPIO的BSRR，DIR/EN为74HC595级联输出的位序号(常量表，放在Flash中)
+typedef struct {
+    GPIO_TypeDef* step_port;   // STEP引脚端口
+    uint16_t step_pin;         // STEP引脚位掩码(GPIO_PIN_x)
+    uint8_t dir_bit;           // DIR输出位序号
+    uint8_t en_bit;            // EN输出位序号
+} StepperPinDesc_t;
+
+// 扩展输出写函数: 按位序号修改74HC595输出映像，返回本次修改的映像序号
+// (DIR/EN只在启停和换向时写，不在边沿路径上，可能在中断中调用)
+typedef uint32_t (*StepperExpanderFunc_t)(uint8_t bit, uint8_t state);
+
+// DMA脉冲序列撤销函数: 删除STEP引脚在缓冲区中还没有输出的边沿并保证引脚回到低电平，
+// 返回已计入位置但被撤销的步数(限位中断中调用)
+typedef int16_t (*StepperDmaCancelFunc_t)(uint8_t port, uint16_t pin);
+
+// 匀速段PWM输出接口(由PWM输出模块提供，时间单位us)
+struct StepperMotor;
+typedef struct StepperPwmOps {
+    // 从现在起lead后输出第一步，之后每period(Q8，us)一步，共steps步；
+    // 返回第一步到这些步之后下一步的时间(按定时器实际周期)，0为不能输出(忙或超出范围)
+    uint32_t (*start)(struct StepperMotor* motor, uint32_t lead, uint32_t period, uint32_t steps);
+    // 尽早结束(留出边沿路径重新接管的时间)，返回从末尾去掉的步数(来不及时返回0)，early为结束提前的时间
+    uint32_t (*cut)(struct StepperMotor* motor, uint32_t* early);
+    // 立即停止并保证引脚回到低电平，返回还没有输出的步数
+    uint32_t (*cancel)(struct StepperMotor* motor);
+} StepperPwmOps_t;
+
+// 编码器读函数: 返回16位计数器的当前值(边沿路径和主循环中调用)
+typedef uint16_t (*StepperEncoderFunc_t)(struct StepperMotor* motor);
+
+// 运动段队列回调: 当前段结束时(比较中断中)取下一段，无后续段返回NULL
+struct StepperBlock;
+typedef const struct StepperBlock* (*StepperBlockFunc_t)(void* ctx);
+
 // 步进电机结构体
 typedef struct StepperMotor {
     // 引脚控制回调函数
     PinControlFunc_t PinControl;   // 引脚控制回调函数
+    const StepperPinDesc_t* pins;  // 引脚描述，不为NULL时代替引脚控制回调
     
     // 运行状态
     StepperState_t state;      // 电机状态
@@ -41,24 +184,163 @@ typedef struct StepperMotor {
     uint32_t target_position;  // 目标位置
     
     // 速度参数
-    uint32_t step_delay;       // 步进延时(us)
-    uint32_t min_step_delay;   // 最小步进延时(最大速度)
-    uint32_t max_step_delay;   // 最大步进延时(启动速度)
+    StepperProfile_t profile;  // 加减速曲线类型
+    uint32_t max_speed;        // 最大速度(步/秒，小数速度取整，用于曲线计算)
+    uint32_t start_speed;      // 启动速度(步/秒，同上)
+    uint32_t speed_delay;      // 设定的最大速度对应的延时(Q8，us)，保留小数速度
+    uint32_t start_delay;      // 设定的启动速度对应的延时(Q8，us)
+    uint32_t accel;            // 加速度(步/秒^2)
+    uint32_t jerk;             // 加加速度(步/秒^3)，0表示不限制(S曲线退化为梯形)
+    uint32_t step_delay;       // 步进延时(Q8，us)
+    uint32_t min_step_delay;   // 最小步进延时(Q8，最大速度)
+    uint32_t max_step_delay;   // 最大步进延时(Q8，启动速度)
     uint32_t accel_steps;      // 加速步数
     uint32_t accel_count;      // 当前已执行的加速/减速步数
-      // 时间控制
-    uint64_t last_step_time;   // 上次步进时间
+    uint32_t ramp_scale;       // 步数到表位置的比例(Q24，STEPPER_RAMP_SEGMENTS<<24/accel_steps)
+    uint32_t ramp_table[STEPPER_RAMP_SEGMENTS + 1]; // 加减速延时表(Q8，us)，由Stepper_SetSpeed生成
+    uint32_t accel_n0;         // 恒加速度: 启动速度对应的递推序号(v^2/2a)
+    uint32_t ramp_c0;          // 恒加速度: 起步延时(Q8，us)
+    uint32_t ramp_c;           // 恒加速度: 当前延时(Q8，us)
+    uint32_t ramp_vmax;        // S曲线: 延时表对应的最高速度(短距离运动会降低)
+    
+    // 工程单位: 由Stepper_SetUnits预先计算比例和倒数，换算时只做乘法和移位
+    uint32_t steps_per_unit;   // 每单位整步数(Q16.16)
+    uint16_t microstep;        // 细分数
+    uint8_t dir_invert;        // 1 DIR引脚电平取反(正转输出高电平)
+    uint8_t unit_shift;        // 倒数的移位数
+    uint32_t unit_scale;       // 每单位微步数(Q16.16，steps_per_unit*microstep)
+    uint32_t unit_recip;       // 每微步单位数(2^unit_shift/单位微步数)
+    // 时间控制
+    uint32_t last_step_time;   // 上次步进时间(bsp_GetTimeUs)
+    uint32_t edge_delay;       // 到下一个脉冲边沿的延时(us)
+    uint32_t step_period;      // 当前步周期(us，步进延时加上累加的小数部分取整)
+    uint8_t step_phase;        // 步进延时小数部分的累加值(Q8，us)
+    uint32_t wait_ticks;       // 长延时分段等待的剩余时间(us)
     uint8_t pulse_state;       // PWM脉冲状态
+    uint8_t timer_channel;     // 占用的定时器比较通道(0~3)，STEPPER_CHANNEL_NONE为轮询方式
+    
+    // 直线插补(DDA): 从动轴在主轴每步累加dda_num，超过dda_den时输出一步
+    struct StepperMotor* sync_master; // 从动轴所跟随的主轴，NULL表示独立运行
+    struct StepperMotor* sync_next;   // 主轴的从动轴链表
+    uint32_t dda_num;          // 从动轴总步数
+    uint32_t dda_den;          // 主轴总步数
+    uint32_t dda_err;          // Bresenham误差累加器
+    
+    // 电子齿轮(DDA): 跟随轴在主轴每步累加gear_num，超过gear_den时输出一步，跨越主轴多次运动保持
+    struct StepperMotor* gear_master; // 跟随的主轴，NULL表示未挂接
+    struct StepperMotor* gear_list;   // 跟随本轴的跟随轴链表
+    struct StepperMotor* gear_next;   // 同一主轴的下一个跟随轴
+    uint16_t gear_num;         // 比例分子(不超过分母)
+    uint16_t gear_den;         // 比例分母
+    uint16_t gear_err;         // 误差累加器
+    uint8_t gear_reverse;      // 1 与主轴反向
+    
+    // 步段流水线: 主循环按规划游标(plan_remain)计算步段，比较中断只取步段
+    StepperSegment_t seg_ring[STEPPER_SEG_RING]; // 步段环形队列
+    volatile uint8_t seg_head; // 写入位置(主循环)
+    volatile uint8_t seg_tail; // 读取位置(中断)
+    uint8_t seg_enabled;       // 使能流水线
+    uint8_t seg_active;        // 当前运动使用流水线
+    uint16_t seg_left;         // 当前步段剩余步数
+    uint32_t seg_delay;        // 当前步延时(Q8，us)
+    int32_t seg_delta;         // 当前步段每步延时增量(Q8，us)
+    uint32_t plan_remain;      // 规划游标之后的剩余步数
+    uint32_t seg_underrun;     // 欠载次数
+    uint8_t seg_depth_min;     // 运行中的最小队列深度
+    
+    // 运动段队列: 当前段到位时由block_func取下一段，不经过停止直接衔接
+    StepperBlockFunc_t block_func; // 取下一段的回调函数，NULL表示没有队列
+    void* block_ctx;           // 回调函数参数
+    uint32_t exit_count;       // 恒加速度: 减速结束时的递推序号(运动段的退出速度，独立运动为0)
+    uint8_t block_active;      // 正在执行运动段(速度参数被临时改写，下次独立运动前恢复)
+    
+    // 运行中改目标: 新目标在反方向或来不及减速时先减速停止，停止后再运动到retarget
+    uint32_t retarget;         // 停止后要运动到的目标位置
+    int32_t jog_speed;         // 速度模式反向时，停止后要加速到的速度(步/秒，带方向)
+    uint8_t retarget_pending;  // 停止后待执行的运动(STEPPER_RETARGET_x)，0为没有
+    
+    // DMA脉冲序列: 边沿写入输出缓冲区，不占用比较通道
+    uint8_t dma_port;          // 输出端口(STEPPER_DMA_PORT_x)，STEPPER_DMA_NONE为不使用
+    volatile uint8_t dma_run;  // 正在由DMA缓冲区输出
+    uint16_t dma_pin;          // STEP引脚位掩码
+    uint32_t dma_next;         // 下一个边沿相对于待填充半缓冲区起点的时间(us)
+    
+    // 匀速段PWM输出: 交出的步数在交出时计入位置，边沿路径的下一个边沿推迟到PWM输出完成时
+    const StepperPwmOps_t* pwm_ops; // PWM输出接口，NULL为不使用
+    volatile uint8_t pwm_busy; // PWM正在输出(完成中断中清除)
+    uint8_t seg_pwm;           // 中断刚取出一个PWM步段
+    uint32_t pwm_period;       // PWM输出的步进延时(Q8，us)
+    uint32_t pwm_accel_count;  // 流水线: 生成PWM步段时的accel_count，截短后从此恢复规划游标
+    
+    // 步进时序跟踪: 每个上升沿取时间戳，与上一个上升沿的间隔和规划间隔比较
+    uint8_t trace_on;          // 使能跟踪
+    uint8_t trace_valid;       // 上一个上升沿的时间戳有效(启动和PWM输出之后的第一个沿无效)
+    uint32_t trace_last;       // 上一个上升沿的时间戳(us)
+    uint32_t trace_period;     // 上一步的步周期(us)
+    int16_t trace_err_min;     // 最小误差(us)
+    int16_t trace_err_max;     // 最大误差(us)
+    int32_t trace_err_sum;     // 误差累计值
+    uint16_t trace_err_span;   // 误差累计的间隔数
+    uint32_t trace_count;      // 统计的间隔总数
+    
+    // 反向间隙补偿: 规划器在反向的运动段前插入补偿段，补偿步数计入position但不计入对外的位置
+    uint16_t backlash;         // 反向间隙(步)，0为不补偿
+    int32_t backlash_pending;  // 最近一个补偿段的步数(正转为正)
+    uint32_t backlash_from;    // 最近一个补偿段起点的position
+    int32_t backlash_offset;   // 该补偿段之前累计的补偿步数(正转为正)
+    
+    // 编码器闭环: 计数器增量换算为步数与position比较，运行中把少走的步数加到剩余步数
+    StepperEncoderFunc_t enc_read; // 读编码器计数器，NULL为开环
+    int32_t enc_scale;         // 每个计数的步数(Q16.16，负数为计数方向与正转相反)
+    uint16_t enc_last;         // 上次读到的计数器值
+    uint16_t enc_frac;         // 换算的小数部分(Q16)
+    uint32_t enc_position;     // 编码器换算的位置(步)
+    int32_t enc_error;         // 最近一次采样的跟随误差(编码器位置-position)
+    int32_t enc_error_max;     // 绝对值最大的跟随误差
+    uint16_t enc_window;       // 跟随误差超过此步数时补步
+    uint16_t enc_stall;        // 编码器不前进时补步和滞后超过此步数判为堵转
+    uint32_t enc_mark;         // 本次运动中编码器沿运动方向到达的最远位置
+    uint32_t enc_slip;         // 编码器到达最远位置之后的补步数
+    uint32_t enc_corrected;    // 累计补步数
+    uint16_t enc_corrections;  // 补步次数
+    uint32_t enc_idle_time;    // 停止的时刻(bsp_GetTimeUs)
+    uint8_t enc_idle;          // 已记录停止时刻
+    uint8_t enc_retry;         // 停止后连续补步的次数
+    uint8_t enc_fault;         // 故障(STEPPER_ENC_x)，故障后不再补步
+    
+    // 扩展输出: DIR/EN写入映像后要等主循环移位输出并经过建立时间才能产生边沿
+    uint32_t io_seq;           // 最近一次DIR/EN修改的映像序号
+    uint8_t io_pending;        // DIR/EN修改尚未确认到达引脚
+    volatile uint8_t io_wait;  // 等待DIR/EN生效后由Stepper_ProcessAllMotors启动脉冲
     
     // 限位开关标志
     uint8_t limit_enabled;     // 限位开关使能标志
     uint8_t cw_limit;          // 正转限位开关状态(1=触发)
     uint8_t ccw_limit;         // 反转限位开关状态(1=触发)
+    volatile uint32_t latch_position; // 限位中断触发时锁存的位置
+    volatile uint8_t latch_valid;     // 锁存位置有效(读取后清除)
     
     // 链表指针，用于管理多个电机
     struct StepperMotor* next;
 } StepperMotor_t;
 
+// 运动段: 由规划器生成，主轴按恒加速度递推运行，速度用递推序号 n = v^2/(2a) 表示
+typedef struct StepperBlock {
+    StepperMotor_t* const* axes;                  // 参与运动的轴
+    uint8_t axis_count;                           // 轴数
+    uint8_t major;                                // 主轴序号(步数最多的轴)
+    uint8_t dir[STEPPER_LINEAR_MAX_AXES];         // 各轴方向
+    uint32_t target[STEPPER_LINEAR_MAX_AXES];     // 各轴目标位置
+    uint32_t steps[STEPPER_LINEAR_MAX_AXES];      // 各轴步数
+    uint32_t entry_n;                             // 进入速度的递推序号
+    uint32_t exit_n;                              // 退出速度的递推序号
+    uint32_t max_n;                               // 匀速速度的递推序号
+    uint32_t entry_c;                             // 进入速度对应的延时(Q8，us)
+    uint32_t min_delay;                           // 匀速延时(Q8，us)
+    uint32_t exit_delay;                          // 退出速度对应的延时(Q8，us)
+    uint8_t backlash;                             // 1 反向间隙补偿段(各轴步数不计入对外的位置)
+} StepperBlock_t;
+
 /**
  * @brief 注册步进电机引脚控制回调函数
  * @param motor 步进电机结构体指针
@@ -67,6 +349,14 @@ typedef struct StepperMotor {
  */
 void Stepper_RegisterPinControl(StepperMotor_t* motor, PinControlFunc_t pinControlFunc);
 
+/**
+ * @brief 初始化步进脉冲引擎定时器(应在Stepper_Init之前调用)
+ * @return None
+ * @note 初始化后新注册的电机依次占用定时器比较通道，脉冲边沿在比较中断中产生，
+ *       不再依赖主循环轮询；超出通道数的电机仍由Stepper_ProcessAllMotors轮询
+ */
+void Stepper_TimerInit(void);
+
 /**
  * @brief 初始化步进电机
  * @param motor 步进电机结构体指针
@@ -75,6 +365,33 @@ void Stepper_RegisterPinControl(StepperMotor_t* motor, PinControlFunc_t pinContr
  */
 void Stepper_Init(StepperMotor_t* motor, PinControlFunc_t pinControlFunc);
 
+/**
+ * @brief 按引脚描述初始化步进电机
+ * @param motor 步进电机结构体指针
+ * @param pins 引脚描述(常量，不复制)
+ * @return None
+ * @note STEP边沿直接写BSRR，不经过函数指针和HAL；同一比较中断或同一次轮询中
+ *       到期的各电机边沿按端口合并为一次BSRR写入。DIR/EN通过Stepper_SetExpander
+ *       注册的函数写扩展输出，应先注册
+ */
+void Stepper_InitPins(StepperMotor_t* motor, const StepperPinDesc_t* pins);
+
+/**
+ * @brief 注册扩展输出写函数(所有使用引脚描述的电机共用)
+ * @param func 扩展输出写函数
+ * @return None
+ */
+void Stepper_SetExpander(StepperExpanderFunc_t func);
+
+/**
+ * @brief 通知扩展输出映像已移位输出(主循环在移位输出后调用)
+ * @param seq 本次输出的映像序号
+ * @return None
+ * @note 修改了DIR/EN的电机在对应序号输出且经过STEPPER_IO_SETUP_US后才产生第一个边沿，
+ *       运动段衔接时换向也在此暂停，不在中断中等待
+ */
+void Stepper_ExpanderFlushed(uint32_t seq);
+
 /**
  * @brief 设置步进电机速度参数
  * @param motor 步进电机结构体指针
@@ -82,9 +399,233 @@ void Stepper_Init(StepperMotor_t* motor, PinControlFunc_t pinControlFunc);
  * @param start_speed 启动速度(步/秒)
  * @param accel 加速度(步/秒^2)
  * @return None
+ * @note 同时生成加减速延时表，运行时每步只查表插值，不做除法
  */
 void Stepper_SetSpeed(StepperMotor_t* motor, uint32_t max_speed, uint32_t start_speed, uint32_t accel);
 
+/**
+ * @brief 按小数速度设置步进电机速度参数
+ * @param motor 步进电机结构体指针
+ * @param max_speed 最大速度(Q16.16，步/秒)
+ * @param start_speed 启动速度(Q16.16，步/秒)
+ * @param accel 加速度(步/秒^2)
+ * @return None
+ * @note 匀速和启动速度按小数速度输出(可以低于1步/秒，最低约0.06步/秒)，
+ *       加减速步数等曲线参数按取整后的速度计算
+ */
+void Stepper_SetSpeedQ16(StepperMotor_t* motor, uint32_t max_speed, uint32_t start_speed, uint32_t accel);
+
+/**
+ * @brief 读取步进电机速度参数
+ * @param motor 步进电机结构体指针
+ * @param speed 速度参数
+ * @return None
+ */
+void Stepper_GetSpeed(const StepperMotor_t* motor, StepperSpeed_t* speed);
+
+/**
+ * @brief 恢复Stepper_GetSpeed读取的速度参数
+ * @param motor 步进电机结构体指针
+ * @param speed 速度参数
+ * @return None
+ * @note 延时原样恢复，Stepper_SetSpeedQ16设置的小数速度不丢失
+ */
+void Stepper_RestoreSpeed(StepperMotor_t* motor, const StepperSpeed_t* speed);
+
+/**
+ * @brief 设置工程单位换算参数
+ * @param motor 步进电机结构体指针
+ * @param steps_per_unit 每单位整步数(Q16.16，例如导程8mm、200步/转的丝杆按0.01mm为单位为0.25*65536)
+ * @param microstep 细分数(1~STEPPER_MICROSTEP_MAX)
+ * @param invert 1 DIR引脚电平取反(电机接线或安装方向相反时使用)
+ * @return 1 成功，0 参数超出范围(每单位微步数为0或超过65535)或运行中修改方向取反
+ * @note 设置时预先计算每单位微步数和它的倒数，之后的单位换算都是乘法和移位。
+ *       位置、速度和加速度使用同一单位(速度为单位/秒，加速度为单位/秒^2)
+ */
+uint8_t Stepper_SetUnits(StepperMotor_t* motor, uint32_t steps_per_unit, uint16_t microstep, uint8_t invert);
+
+/**
+ * @brief 单位换算为微步数(四舍五入)
+ * @param motor 步进电机结构体指针
+ * @param units 单位数
+ * @return 微步数，超出范围时取最大值
+ */
+int32_t Stepper_UnitsToSteps(StepperMotor_t* motor, int32_t units);
+
+/**
+ * @brief 微步数换算为单位(四舍五入)
+ * @param motor 步进电机结构体指针
+ * @param steps 微步数
+ * @return 单位数
+ */
+int32_t Stepper_StepsToUnits(StepperMotor_t* motor, int32_t steps);
+
+/**
+ * @brief 按工程单位设置速度参数
+ * @param motor 步进电机结构体指针
+ * @param max_speed 最大速度(单位/秒)
+ * @param start_speed 启动速度(单位/秒)
+ * @param accel 加速度(单位/秒^2)
+ * @return None
+ * @note 速度换算为Q16.16步/秒后交给Stepper_SetSpeedQ16，小数速度不丢失
+ */
+void Stepper_SetSpeedUnits(StepperMotor_t* motor, uint32_t max_speed, uint32_t start_speed, uint32_t accel);
+
+/**
+ * @brief 按工程单位运动到绝对位置
+ * @param motor 步进电机结构体指针
+ * @param position 目标位置(单位)
+ * @return 1 已启动，0 目标位置换算后小于0
+ */
+uint8_t Stepper_MoveToUnits(StepperMotor_t* motor, int32_t position);
+
+/**
+ * @brief 按工程单位运动相对距离
+ * @param motor 步进电机结构体指针
+ * @param distance 运动距离(单位)，正值为正转，负值为反转
+ * @return None
+ */
+void Stepper_MoveUnits(StepperMotor_t* motor, int32_t distance);
+
+/**
+ * @brief 获取按工程单位表示的当前位置
+ * @param motor 步进电机结构体指针
+ * @return 当前位置(单位)
+ */
+int32_t Stepper_GetPositionUnits(StepperMotor_t* motor);
+
+/**
+ * @brief 设置步进电机加减速曲线类型
+ * @param motor 步进电机结构体指针
+ * @param profile 曲线类型
+ * @return None
+ * @note 恒加速度曲线按 c(n) = c(n-1) - 2c(n-1)/(4n+1) 递推，加减速对称，
+ *       剩余步数等于已加速步数时开始减速，短距离运动自动变为三角形曲线
+ */
+void Stepper_SetProfile(StepperMotor_t* motor, StepperProfile_t profile);
+
+/**
+ * @brief 设置S曲线的加加速度
+ * @param motor 步进电机结构体指针
+ * @param jerk 加加速度(步/秒^3)，0表示不限制
+ * @return None
+ * @note S曲线在设置时按时间积分生成以步数为索引的延时表，运行时与线性曲线一样查表插值；
+ *       距离不足以加速到最大速度时，启动运动前按距离降低最高速度重新生成延时表
+ */
+void Stepper_SetJerk(StepperMotor_t* motor, uint32_t jerk);
+
+/**
+ * @brief 使能步段流水线
+ * @param motor 步进电机结构体指针
+ * @param enable 1 使能  0 禁用
+ * @return None
+ * @note 使能后位置运动的加减速计算移到主循环(Stepper_ProcessAllMotors)，预先生成步段，
+ *       中断中每步只做加法和比较，耗时恒定；主循环来不及填充时中断暂停输出并计入欠载次数。
+ *       匀速运行和运动段队列仍在中断中计算，下次运动时生效
+ */
+void Stepper_EnablePipeline(StepperMotor_t* motor, uint8_t enable);
+
+/**
+ * @brief 把电机的STEP脉冲交给DMA脉冲序列输出
+ * @param motor 步进电机结构体指针
+ * @param port 输出端口(STEPPER_DMA_PORT_x)，STEPPER_DMA_NONE恢复为比较中断/轮询方式
+ * @param pin STEP引脚位掩码(GPIO_PIN_x)
+ * @return None
+ * @note 应在电机空闲时调用。边沿在DMA半传输/传输完成中断中预先写入缓冲区，
+ *       由定时器节拍触发DMA写到BSRR，边沿时刻没有中断；联动轴应使用同一种输出方式
+ */
+void Stepper_AttachDma(StepperMotor_t* motor, uint8_t port, uint16_t pin);
+
+/**
+ * @brief 注册DMA脉冲序列的边沿撤销函数
+ * @param func 撤销函数(由DMA脉冲序列模块提供)
+ * @return None
+ * @note 限位中断停止DMA输出的电机时用来删除已写入缓冲区的边沿，使电机在一步内停止
+ */
+void Stepper_SetDmaCancel(StepperDmaCancelFunc_t func);
+
+/**
+ * @brief 生成半个DMA缓冲区的脉冲序列
+ * @param words 各端口的半缓冲区(STEPPER_DMA_PORTS个，每个ticks个字)
+ * @param ticks 节拍数
+ * @param lead 从现在到这半个缓冲区开始输出的时间(us)，PWM输出按此与缓冲区时间对齐
+ * @return None
+ * @note 由DMA半传输/传输完成中断调用，按各电机的边沿时间写入BSRR置位/复位位
+ */
+void Stepper_DmaRender(uint32_t* const words[], uint16_t ticks, uint32_t lead);
+
+/**
+ * @brief 把电机的匀速段交给硬件PWM输出
+ * @param motor 步进电机结构体指针
+ * @param ops PWM输出接口，NULL为不使用
+ * @return None
+ * @note 应在电机空闲时调用。独立运动(不带联动轴和跟随轴)的匀速段不少于STEPPER_PWM_MIN_STEPS步时，
+ *       在匀速段开始处整段交给PWM输出，边沿路径按原时间轴跳过这些步，匀速段结束后继续减速；
+ *       停止、改目标和限位时截短或撤销PWM输出，位置与引脚上的步数一致
+ */
+void Stepper_AttachPwm(StepperMotor_t* motor, const StepperPwmOps_t* ops);
+
+/**
+ * @brief PWM输出完成(由PWM输出模块在完成中断中调用)
+ * @param motor 步进电机结构体指针
+ * @return None
+ */
+void Stepper_PwmDone(StepperMotor_t* motor);
+
+/**
+ * @brief 获取步段流水线统计
+ * @param motor 步进电机结构体指针
+ * @param stats 统计结果
+ * @return None
+ */
+void Stepper_GetPipelineStats(StepperMotor_t* motor, StepperPipelineStats_t* stats);
+
+/**
+ * @brief 使能或关闭步进时序统计
+ * @param motor 步进电机结构体指针
+ * @param enable 1 使能(同时清除统计)  0 关闭(保留统计结果)
+ * @return None
+ * @note 只统计主轴自己的边沿(联动轴和跟随轴的边沿跟随主轴)；启动运动和PWM输出之后的第一个间隔不统计
+ */
+void Stepper_EnableTrace(StepperMotor_t* motor, uint8_t enable);
+
+/**
+ * @brief 获取步进时序统计
+ * @param motor 步进电机结构体指针
+ * @param stats 统计结果
+ * @return None
+ */
+void Stepper_GetTraceStats(StepperMotor_t* motor, StepperTraceStats_t* stats);
+
+/**
+ * @brief 选择记录上升沿间隔的电机并清空间隔缓冲区
+ * @param motor 步进电机结构体指针(同时使能其时序统计)，NULL为停止记录并保留缓冲区内容
+ * @return None
+ * @note 缓冲区满后覆盖最早的间隔；间隔单位us，超过0xFFFF时记为0xFFFF
+ */
+void Stepper_TraceCapture(StepperMotor_t* motor);
+
+/**
+ * @brief 获取间隔缓冲区中的间隔数
+ * @return 间隔数(不超过STEPPER_TRACE_SIZE)
+ */
+uint16_t Stepper_TraceCount(void);
+
+/**
+ * @brief 读取间隔缓冲区
+ * @param index 序号(0为最早的间隔)
+ * @return 间隔(us)，序号超出间隔数时返回0
+ * @note 记录中读取时间隔可能移动，应先停止记录再读取
+ */
+uint16_t Stepper_TraceRead(uint16_t index);
+
+/**
+ * @brief 清除步段流水线统计(欠载次数和最小深度)
+ * @param motor 步进电机结构体指针
+ * @return None
+ */
+void Stepper_ResetPipelineStats(StepperMotor_t* motor);
+
 /**
  * @brief 设置步进电机目标位置(相对运动)
  * @param motor 步进电机结构体指针
@@ -94,6 +635,50 @@ void Stepper_SetSpeed(StepperMotor_t* motor, uint32_t max_speed, uint32_t start_
  */
 void Stepper_Move(StepperMotor_t* motor, uint32_t steps, StepperDirection_t dir);
 
+/**
+ * @brief 多轴直线插补运动(绝对位置)
+ * @param axes 参与运动的电机指针数组
+ * @param targets 各轴目标位置
+ * @param count 轴数(不超过STEPPER_LINEAR_MAX_AXES)
+ * @return None
+ * @note 步数最多的轴作为主轴，按其速度参数和曲线运行；其余轴在主轴每步中按
+ *       Bresenham误差累加分配步数，与主轴同一脉冲边沿输出，各轴同时启动同时到位。
+ *       停止任一联动轴会停止整组运动，运动结束后各轴恢复独立运行
+ */
+void Stepper_MoveLinear(StepperMotor_t* axes[], const uint32_t targets[], uint8_t count);
+
+/**
+ * @brief 电子齿轮: 跟随轴按固定比例跟随主轴的步
+ * @param follower 跟随轴(应处于空闲状态)
+ * @param master 主轴
+ * @param num 比例分子(1~den)，跟随轴步数 = 主轴步数 * num / den
+ * @param den 比例分母(大于0)
+ * @param reverse 1 与主轴反向运动
+ * @return 1 成功  0 参数错误(比例大于1、挂接到自身或形成环)
+ * @note 跟随轴在主轴的脉冲边沿中按误差累加输出，不做速度计算，与主轴同相位，
+ *       主轴的任何运动(包括插补和队列)都会带动跟随轴；比例大于1时以较快的轴为主轴。
+ *       跟随轴的限位会停止主轴，跟随轴单独运动时自动解除挂接
+ */
+uint8_t Stepper_GearAttach(StepperMotor_t* follower, StepperMotor_t* master,
+                           uint16_t num, uint16_t den, uint8_t reverse);
+
+/**
+ * @brief 解除电子齿轮跟随
+ * @param follower 跟随轴
+ * @return None
+ */
+void Stepper_GearDetach(StepperMotor_t* follower);
+
+/**
+ * @brief 启动运动段队列的第一段
+ * @param block 运动段
+ * @param func 取下一段的回调函数(在比较中断中调用)
+ * @param ctx 回调函数参数
+ * @return None
+ * @note 段与段之间在主轴最后一步的下降沿直接衔接，主轴不同时把定时交给新的主轴
+ */
+void Stepper_StartBlock(const StepperBlock_t* block, StepperBlockFunc_t func, void* ctx);
+
 /**
  * @brief 设置步进电机目标位置(绝对运动)
  * @param motor 步进电机结构体指针
@@ -102,11 +687,35 @@ void Stepper_Move(StepperMotor_t* motor, uint32_t steps, StepperDirection_t dir)
  */
 void Stepper_MoveTo(StepperMotor_t* motor, uint32_t position);
 
+/**
+ * @brief 运行中修改目标位置(绝对位置)，不停止
+ * @param motor 步进电机结构体指针
+ * @param position 新的目标位置
+ * @return None
+ * @note 从当前瞬时速度按恒加速度递推重新规划: 新目标在前方且来得及减速时直接加速、
+ *       匀速或减速到新目标；在后方或来不及减速时先按加速度减速停止，停止后由
+ *       Stepper_ProcessAllMotors反向运动到新目标。电机空闲、联动或执行运动段队列时
+ *       等同于Stepper_MoveTo
+ */
+void Stepper_UpdateTarget(StepperMotor_t* motor, uint32_t position);
+
+/**
+ * @brief 运行中修改最大速度，不停止
+ * @param motor 步进电机结构体指针
+ * @param max_speed 新的最大速度(步/秒)
+ * @return None
+ * @note 运行中从当前瞬时速度加速或减速到新的最大速度，目标不变；
+ *       电机空闲时等同于Stepper_SetSpeed只修改最大速度
+ */
+void Stepper_UpdateMaxSpeed(StepperMotor_t* motor, uint32_t max_speed);
+
 /**
  * @brief 停止步进电机
  * @param motor 步进电机结构体指针
  * @param immediate 是否立即停止
  * @return None
+ * @note 减速停止时由当前瞬时速度和设定加速度计算制动距离(含匀速运行)，从当前速度
+ *       直接减速到启动速度后停止；S曲线独立运动按已加速步数反向查表减速
  */
 void Stepper_Stop(StepperMotor_t* motor, uint8_t immediate);
 
@@ -119,7 +728,7 @@ void Stepper_Stop(StepperMotor_t* motor, uint8_t immediate);
 void Stepper_Enable(StepperMotor_t* motor, uint8_t enable);
 
 /**
- * @brief 步进电机周期性处理函数(应该在主循环或定时器中调用)
+ * @brief 步进电机周期性处理函数(轮询方式，应该在主循环中调用)
  * @param motor 步进电机结构体指针
  * @return None
  */
@@ -135,20 +744,33 @@ StepperState_t Stepper_GetState(StepperMotor_t* motor);
 /**
  * @brief 获取步进电机位置
  * @param motor 步进电机结构体指针
- * @return 当前位置
+ * @return 当前位置(不含反向间隙补偿步数，补偿段执行中保持不变)
  */
 uint32_t Stepper_GetPosition(StepperMotor_t* motor);
 
+/**
+ * @brief 设置反向间隙
+ * @param motor 步进电机结构体指针
+ * @param steps 反向间隙(步)，0为不补偿
+ * @return None
+ * @note 由规划器补偿: 某轴的运动方向与上一次相反时，先以该段的速度插入间隙步数的补偿段。
+ *       补偿步数计入position(正转后position比对外的位置多出间隙，反转后相等)，
+ *       Stepper_GetPosition和规划器的目标位置不含补偿步数
+ */
+void Stepper_SetBacklash(StepperMotor_t* motor, uint16_t steps);
+
 /**
  * @brief 复位步进电机位置计数器
  * @param motor 步进电机结构体指针
  * @return None
+ * @note 对外的位置清零；设置了反向间隙且最近为正转时，position为间隙步数
  */
 void Stepper_ResetPosition(StepperMotor_t* motor);
 
 /**
  * @brief 管理多个步进电机的处理函数(在主循环中调用)
  * @return None
+ * @note 已分配定时器比较通道的电机由中断驱动，此函数处理轮询方式的电机并填充步段流水线
  */
 void Stepper_ProcessAllMotors(void);
 
@@ -174,6 +796,16 @@ void Stepper_RemoveMotor(StepperMotor_t* motor);
  */
 void Stepper_RunSpeed(StepperMotor_t* motor, int32_t speed);
 
+/**
+ * @brief 速度模式运行(按加速度变速)
+ * @param motor 步进电机结构体指针
+ * @param speed 目标速度(步/秒)，正值为顺时针，负值为逆时针，0为减速停止
+ * @return None
+ * @note 运行中可反复调用: 同方向从当前速度按加速度加速或减速到新速度，反方向先减速
+ *       停止再反向加速；速度不超过最大速度。加速度为0时等同于Stepper_RunSpeed
+ */
+void Stepper_Jog(StepperMotor_t* motor, int32_t speed);
+
 /**
  * @brief 设置限位开关状态
  * @param motor 步进电机结构体指针
@@ -191,13 +823,78 @@ void Stepper_SetLimitSwitches(StepperMotor_t* motor, uint8_t cw_limit, uint8_t c
  */
 void Stepper_EnableLimitSwitches(StepperMotor_t* motor, uint8_t enable);
 
+/**
+ * @brief 限位开关电平变化(在限位输入中断中调用)
+ * @param motor 限位所属电机
+ * @param side 限位所在方向
+ * @param active 1 触发  0 释放
+ * @return None
+ * @note 使能限位且电机正朝限位方向运动时，在中断中立即停止整组运动(插补主轴和跟随的主轴)：
+ *       正在输出的脉冲补完，DMA缓冲区中还没有输出的边沿被撤销，位置计数与引脚上的步数一致，
+ *       并锁存此时的位置。反转限位同时作为原点，锁存后位置清零。
+ *       中断优先级应与DMA脉冲序列的填充中断相同
+ */
+void Stepper_LimitEvent(StepperMotor_t* motor, StepperDirection_t side, uint8_t active);
+
+/**
+ * @brief 读取限位中断锁存的位置
+ * @param motor 步进电机结构体指针
+ * @param position 锁存位置(清零前的位置计数)
+ * @return 1 有新的锁存(读取后清除)  0 没有
+ */
+uint8_t Stepper_GetLatch(StepperMotor_t* motor, uint32_t* position);
+
 /**
  * @brief 回归零点（寻找原点）
  * @param motor 步进电机结构体指针
  * @param speed 回归速度(步/秒)，使用正值（内部会转为反转方向）
  * @return None
- * @note 该函数会使电机反转直到触发反转限位开关，然后将该位置设置为0
+ * @note 该函数会使电机反转直到触发反转限位开关，然后将该位置设置为0；
+ *       快速寻找、退离、慢速锁存和偏移的完整回原点见bsp_home
  */
 void Stepper_GoHome(StepperMotor_t* motor, uint32_t speed);
 
+/**
+ * @brief 挂接编码器，使能闭环
+ * @param motor 步进电机结构体指针
+ * @param read 读编码器计数器的函数，NULL恢复为开环
+ * @param steps_per_count 每个编码器计数的步数(Q16.16，负数为计数方向与正转相反)
+ * @param window 跟随误差超过此步数时补步(应大于负载下正常的滞后)
+ * @param stall 编码器不再前进时，补步数和滞后之和超过此步数判为堵转(大于window)
+ * @return None
+ * @note 应在电机空闲时调用，挂接时编码器位置同步为当前位置。比较中断和轮询方式的电机在每步的
+ *       下降沿采样，DMA输出的电机和停止的电机由Stepper_ProcessAllMotors采样(DMA输出的位置
+ *       超前引脚，误差扣除STEPPER_ENC_DMA_LEAD_US内的步数)。运行中滞后超过window时
+ *       把位置改为编码器位置并延长剩余步数，在原目标处停止；联动轴和电子齿轮的轴只在停止后补步。
+ *       编码器不再前进、补步和滞后累计超过stall时立即停止并把位置改为编码器位置，
+ *       置STEPPER_ENC_STALL，之后不再补步。
+ *       闭环时匀速段不交给PWM输出。两次采样之间的计数变化换算的步数应小于32768
+ */
+void Stepper_AttachEncoder(StepperMotor_t* motor, StepperEncoderFunc_t read, int32_t steps_per_count,
+                           uint16_t window, uint16_t stall);
+
+/**
+ * @brief 把编码器位置同步为当前位置计数并清除故障和最大误差
+ * @param motor 步进电机结构体指针
+ * @return None
+ * @note 位置计数被重新设定时(复位位置、原点清零)自动调用
+ */
+void Stepper_EncoderSync(StepperMotor_t* motor);
+
+/**
+ * @brief 获取编码器闭环统计
+ * @param motor 步进电机结构体指针
+ * @param stats 统计结果
+ * @return None
+ */
+void Stepper_GetEncoderStats(StepperMotor_t* motor, StepperEncoderStats_t* stats);
+
+/**
+ * @brief 整数平方根(向下取整)
+ * @param x 被开方数
+ * @return 平方根
+ * @note 逐位计算，耗时较长，只在设置参数和规划运动时使用
+ */
+uint32_t Stepper_Sqrt(uint64_t x);
+
 #endif // !__BSP_MOTOR_H
\ No newline at end of file
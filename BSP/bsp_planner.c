@@ -0,0 +1,426 @@
+/**
+ * @file bsp_planner.c
+ * @brief 运动段队列与前瞻速度规划
+ * @note 队列由主循环写入、比较中断读取。每添加一段都从队尾向前(减速约束)、
+ *       再从队首向后(加速约束)重新计算各段的衔接速度；速度换算为恒加速度
+ *       递推序号后交给bsp_motor执行，比较中断中不做规划计算
+ */
+
+#include "bsp_planner.h"
+#include <stdlib.h>
+
+// 临界区保护(主循环规划结果写回时，比较中断可能正在取下一段)
+#define PLANNER_ENTER_CRITICAL()    uint32_t _primask = __get_PRIMASK(); __disable_irq()
+#define PLANNER_EXIT_CRITICAL()     __set_PRIMASK(_primask)
+
+#define PLANNER_NEXT(i)             (uint8_t)(((i) + 1) % PLANNER_QUEUE_SIZE)
+#define PLANNER_PREV(i)             (uint8_t)(((i) + PLANNER_QUEUE_SIZE - 1) % PLANNER_QUEUE_SIZE)
+
+// 私有函数声明
+static const StepperBlock_t* Planner_NextBlock(void* ctx);
+static void Planner_Recalculate(Planner_t* planner);
+static void Planner_SetExec(PlannerBlock_t* block, uint32_t entry_speed, uint32_t exit_speed);
+static uint32_t Planner_ReachSpeed(uint32_t speed, uint32_t accel, uint32_t steps);
+static int32_t Planner_AxisSpeed(const PlannerBlock_t* block, uint8_t axis);
+static void Planner_SyncPosition(Planner_t* planner);
+static void Planner_Push(Planner_t* planner, const uint32_t targets[], uint32_t speed, uint8_t backlash);
+
+/**
+ * @brief 初始化规划器
+ */
+void Planner_Init(Planner_t* planner, StepperMotor_t* axes[], uint8_t count)
+{
+    if (planner == NULL || axes == NULL || count == 0 || count > STEPPER_LINEAR_MAX_AXES) {
+        return;
+    }
+
+    for (uint8_t i = 0; i < count; i++) {
+        planner->axes[i] = axes[i];
+    }
+    planner->axis_count = count;
+    planner->head = 0;
+    planner->tail = 0;
+    planner->running = 0;
+    Planner_SyncPosition(planner);
+}
+
+/**
+ * @brief 添加一段直线运动(绝对位置)
+ */
+uint8_t Planner_Enqueue(Planner_t* planner, const uint32_t targets[], uint32_t speed)
+{
+    uint32_t lash[STEPPER_LINEAR_MAX_AXES];
+    uint32_t motor_targets[STEPPER_LINEAR_MAX_AXES];
+    int32_t comp[STEPPER_LINEAR_MAX_AXES];
+    uint8_t reverse = 0;
+
+    // 队列空闲时电机可能被队列之外的运动移动过(直接运动、回原点、限位清零)，
+    // 先把队列终点同步为电机当前位置
+    PLANNER_ENTER_CRITICAL();
+    if (!planner->running && planner->tail == planner->head) {
+        Planner_SyncPosition(planner);
+    }
+    PLANNER_EXIT_CRITICAL();
+
+    // 目标换算为电机位置。补偿步数正转后为间隙、反转后为0，
+    // 运动方向改变了间隙所在的一侧时先走补偿段
+    for (uint8_t i = 0; i < planner->axis_count; i++) {
+        uint32_t target = targets[i] + (uint32_t)planner->backlash[i];
+
+        comp[i] = 0;
+        if (target > planner->position[i]) {
+            int32_t side = (int32_t)planner->axes[i]->backlash;
+            comp[i] = (side > planner->backlash[i]) ? side - planner->backlash[i] : 0;
+        } else if (target < planner->position[i]) {
+            comp[i] = -planner->backlash[i];
+        }
+        if (comp[i] != 0) {
+            reverse = 1;
+        }
+        lash[i] = planner->position[i] + (uint32_t)comp[i];
+        motor_targets[i] = target + (uint32_t)comp[i];
+    }
+
+    if (Planner_GetFree(planner) < (reverse ? 2 : 1)) {
+        return 0;
+    }
+
+    for (uint8_t i = 0; i < planner->axis_count; i++) {
+        planner->backlash[i] += comp[i];
+    }
+    if (reverse) {
+        Planner_Push(planner, lash, speed, 1);
+    }
+    Planner_Push(planner, motor_targets, speed, 0);
+
+    Planner_Recalculate(planner);
+    return 1;
+}
+
+/**
+ * @brief 在队尾添加一段(电机位置)，由调用者检查队列空间并重新规划
+ */
+static void Planner_Push(Planner_t* planner, const uint32_t targets[], uint32_t speed, uint8_t backlash)
+{
+    uint8_t head = planner->head;
+    PlannerBlock_t* block = &planner->blocks[head];
+    StepperBlock_t* exec = &block->exec;
+    uint32_t major_steps = 0;
+    uint32_t k;
+
+    // 各轴步数和方向，步数最多的轴作为主轴
+    exec->axes = planner->axes;
+    exec->axis_count = planner->axis_count;
+    exec->major = 0;
+    for (uint8_t i = 0; i < planner->axis_count; i++) {
+        exec->target[i] = targets[i];
+        if (targets[i] >= planner->position[i]) {
+            exec->steps[i] = targets[i] - planner->position[i];
+            exec->dir[i] = STEPPER_DIR_CW;
+        } else {
+            exec->steps[i] = planner->position[i] - targets[i];
+            exec->dir[i] = STEPPER_DIR_CCW;
+        }
+
+        if (exec->steps[i] > major_steps) {
+            major_steps = exec->steps[i];
+            exec->major = i;
+        }
+    }
+
+    if (major_steps == 0) {
+        return;
+    }
+    exec->backlash = backlash;
+
+    StepperMotor_t* major = planner->axes[exec->major];
+    block->nominal_speed = (speed > 0) ? speed : major->max_speed;
+    if (block->nominal_speed == 0) {
+        block->nominal_speed = 1;
+    }
+    block->accel = major->accel;
+
+    // 从静止启动: 各轴速度都不超过自身启动速度(比例系数Q16)
+    k = 0x10000;
+    for (uint8_t i = 0; i < planner->axis_count; i++) {
+        uint32_t v = (uint32_t)abs(Planner_AxisSpeed(block, i));
+        uint32_t limit = planner->axes[i]->start_speed;
+
+        if (v > limit) {
+            uint32_t ki = (uint32_t)(((uint64_t)limit << 16) / v);
+            if (ki < k) {
+                k = ki;
+            }
+        }
+    }
+    block->stop_speed = (uint32_t)(((uint64_t)block->nominal_speed * k) >> 16);
+    if (block->stop_speed == 0) {
+        block->stop_speed = 1;
+    }
+
+    // 与上一段衔接: 前后两段按同一比例缩放，各轴速度跳变不超过自身启动速度
+    block->max_entry_speed = block->stop_speed;
+    if (head != planner->tail) {
+        const PlannerBlock_t* prev = &planner->blocks[PLANNER_PREV(head)];
+
+        k = 0x10000;
+        for (uint8_t i = 0; i < planner->axis_count; i++) {
+            uint32_t jump = (uint32_t)abs(Planner_AxisSpeed(prev, i) - Planner_AxisSpeed(block, i));
+            uint32_t limit = planner->axes[i]->start_speed;
+
+            if (jump > limit) {
+                uint32_t ki = (uint32_t)(((uint64_t)limit << 16) / jump);
+                if (ki < k) {
+                    k = ki;
+                }
+            }
+        }
+
+        uint32_t junction = (uint32_t)(((uint64_t)block->nominal_speed * k) >> 16);
+        if (junction > block->max_entry_speed) {
+            block->max_entry_speed = junction;
+        }
+    }
+
+    // 新段先按停止规划，加入队列后再整体重新规划
+    block->entry_speed = block->stop_speed;
+    block->exit_speed = block->stop_speed;
+    Planner_SetExec(block, block->entry_speed, block->exit_speed);
+
+    for (uint8_t i = 0; i < planner->axis_count; i++) {
+        planner->position[i] = targets[i];
+    }
+    planner->head = PLANNER_NEXT(head);
+}
+
+/**
+ * @brief 规划器轮询
+ */
+void Planner_Poll(Planner_t* planner)
+{
+    const StepperBlock_t* block;
+
+    if (planner->running) {
+        for (uint8_t i = 0; i < planner->axis_count; i++) {
+            if (planner->axes[i]->state != STEPPER_STATE_IDLE) {
+                return;
+            }
+        }
+
+        // 队列未执行完电机已停止(被停止或限位触发)，丢弃剩余各段
+        PLANNER_ENTER_CRITICAL();
+        planner->tail = planner->head;
+        planner->running = 0;
+        PLANNER_EXIT_CRITICAL();
+        Planner_SyncPosition(planner);
+        return;
+    }
+
+    if (planner->tail == planner->head) {
+        return;
+    }
+
+    PLANNER_ENTER_CRITICAL();
+    block = &planner->blocks[planner->tail].exec;
+    planner->tail = PLANNER_NEXT(planner->tail);
+    planner->running = 1;
+    PLANNER_EXIT_CRITICAL();
+
+    Stepper_StartBlock(block, Planner_NextBlock, planner);
+}
+
+/**
+ * @brief 立即停止并清空队列
+ */
+void Planner_Clear(Planner_t* planner)
+{
+    PLANNER_ENTER_CRITICAL();
+    planner->tail = planner->head;
+    planner->running = 0;
+    PLANNER_EXIT_CRITICAL();
+
+    for (uint8_t i = 0; i < planner->axis_count; i++) {
+        Stepper_Stop(planner->axes[i], 1);
+    }
+    Planner_SyncPosition(planner);
+}
+
+/**
+ * @brief 获取队列剩余空间
+ */
+uint8_t Planner_GetFree(const Planner_t* planner)
+{
+    uint8_t used = (uint8_t)((planner->head + PLANNER_QUEUE_SIZE - planner->tail) % PLANNER_QUEUE_SIZE);
+
+    return (uint8_t)(PLANNER_QUEUE_SIZE - 1 - used);
+}
+
+/**
+ * @brief 取下一段(比较中断中由主轴到位时调用)
+ */
+static const StepperBlock_t* Planner_NextBlock(void* ctx)
+{
+    Planner_t* planner = (Planner_t*)ctx;
+    const StepperBlock_t* block;
+
+    if (planner->tail == planner->head) {
+        planner->running = 0;
+        return NULL;
+    }
+
+    block = &planner->blocks[planner->tail].exec;
+    planner->tail = PLANNER_NEXT(planner->tail);
+    return block;
+}
+
+/**
+ * @brief 重新规划队列中各段的进入和退出速度
+ * @note 队列第一段的进入速度等于正在执行段的退出速度，已经确定，不再修改；
+ *       计算在局部数组中进行，写回时若比较中断已取走第一段则重新计算
+ */
+static void Planner_Recalculate(Planner_t* planner)
+{
+    uint32_t v_entry[PLANNER_QUEUE_SIZE];
+    uint32_t v_exit[PLANNER_QUEUE_SIZE];
+    uint8_t tail, count, k;
+    uint8_t done = 0;
+
+    while (!done) {
+        tail = planner->tail;
+        count = (uint8_t)((planner->head + PLANNER_QUEUE_SIZE - tail) % PLANNER_QUEUE_SIZE);
+        if (count == 0) {
+            return;
+        }
+
+        // 反向: 从最后一段停止开始，每段的进入速度不超过能减速到退出速度的速度
+        for (k = count; k-- > 0; ) {
+            const PlannerBlock_t* block = &planner->blocks[(tail + k) % PLANNER_QUEUE_SIZE];
+
+            if (k == count - 1) {
+                v_exit[k] = block->stop_speed;
+            } else {
+                const PlannerBlock_t* next = &planner->blocks[(tail + k + 1) % PLANNER_QUEUE_SIZE];
+                v_exit[k] = (uint32_t)(((uint64_t)v_entry[k + 1] * block->nominal_speed) / next->nominal_speed);
+            }
+
+            if (k == 0) {
+                v_entry[k] = block->entry_speed;
+            } else {
+                v_entry[k] = Planner_ReachSpeed(v_exit[k], block->accel, block->exec.steps[block->exec.major]);
+                if (v_entry[k] > block->max_entry_speed) {
+                    v_entry[k] = block->max_entry_speed;
+                }
+            }
+        }
+
+        // 正向: 每段的退出速度不超过从进入速度能加速到的速度
+        for (k = 0; k < count; k++) {
+            const PlannerBlock_t* block = &planner->blocks[(tail + k) % PLANNER_QUEUE_SIZE];
+            uint32_t reach = Planner_ReachSpeed(v_entry[k], block->accel, block->exec.steps[block->exec.major]);
+
+            if (v_exit[k] > reach) {
+                v_exit[k] = reach;
+            }
+            if (v_exit[k] < block->stop_speed) {
+                v_exit[k] = block->stop_speed;
+            }
+
+            if (k + 1 < count) {
+                const PlannerBlock_t* next = &planner->blocks[(tail + k + 1) % PLANNER_QUEUE_SIZE];
+                uint32_t e = (uint32_t)(((uint64_t)v_exit[k] * next->nominal_speed) / block->nominal_speed);
+
+                if (e < v_entry[k + 1]) {
+                    v_entry[k + 1] = e;
+                }
+                if (v_entry[k + 1] < next->stop_speed) {
+                    v_entry[k + 1] = next->stop_speed;
+                }
+            }
+        }
+
+        PLANNER_ENTER_CRITICAL();
+        if (planner->tail == tail) {
+            for (k = 0; k < count; k++) {
+                PlannerBlock_t* block = &planner->blocks[(tail + k) % PLANNER_QUEUE_SIZE];
+
+                block->entry_speed = v_entry[k];
+                block->exit_speed = v_exit[k];
+                Planner_SetExec(block, v_entry[k], v_exit[k]);
+            }
+            done = 1;
+        }
+        PLANNER_EXIT_CRITICAL();
+    }
+}
+
+/**
+ * @brief 把规划速度换算为比较中断使用的递推序号和延时
+ */
+static void Planner_SetExec(PlannerBlock_t* block, uint32_t entry_speed, uint32_t exit_speed)
+{
+    StepperBlock_t* exec = &block->exec;
+    uint32_t nominal = block->nominal_speed;
+
+    exec->min_delay = 256000000UL / nominal;
+
+    // 不加减速: 整段按匀速速度运行
+    if (block->accel == 0) {
+        exec->entry_n = 0;
+        exec->exit_n = 0;
+        exec->max_n = 0;
+        exec->entry_c = exec->min_delay;
+        exec->exit_delay = exec->min_delay;
+        return;
+    }
+
+    uint64_t two_a = 2 * (uint64_t)block->accel;
+
+    if (entry_speed > nominal) {
+        entry_speed = nominal;
+    }
+    if (exit_speed > nominal) {
+        exit_speed = nominal;
+    }
+
+    exec->entry_n = (uint32_t)(((uint64_t)entry_speed * entry_speed) / two_a);
+    exec->exit_n = (uint32_t)(((uint64_t)exit_speed * exit_speed) / two_a);
+    exec->max_n = (uint32_t)(((uint64_t)nominal * nominal) / two_a);
+    exec->entry_c = 256000000UL / entry_speed;
+    exec->exit_delay = 256000000UL / exit_speed;
+}
+
+/**
+ * @brief 以恒加速度经过steps步后能达到的速度 sqrt(v^2 + 2as)
+ */
+static uint32_t Planner_ReachSpeed(uint32_t speed, uint32_t accel, uint32_t steps)
+{
+    if (accel == 0) {
+        return 0xFFFFFFFF;
+    }
+
+    return Stepper_Sqrt((uint64_t)speed * speed + 2 * (uint64_t)accel * steps);
+}
+
+/**
+ * @brief 运动段以匀速速度运行时某个轴的速度(步/秒，逆时针为负)
+ */
+static int32_t Planner_AxisSpeed(const PlannerBlock_t* block, uint8_t axis)
+{
+    const StepperBlock_t* exec = &block->exec;
+    int32_t v = (int32_t)(((uint64_t)block->nominal_speed * exec->steps[axis]) / exec->steps[exec->major]);
+
+    return (exec->dir[axis] == STEPPER_DIR_CW) ? v : -v;
+}
+
+/**
+ * @brief 队列终点同步为各轴当前位置和补偿步数
+ */
+static void Planner_SyncPosition(Planner_t* planner)
+{
+    for (uint8_t i = 0; i < planner->axis_count; i++) {
+        StepperMotor_t* axis = planner->axes[i];
+
+        planner->position[i] = axis->position;
+        planner->backlash[i] = (int32_t)(axis->position - Stepper_GetPosition(axis));
+    }
+}
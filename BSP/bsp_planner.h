@@ -0,0 +1,81 @@
+/**
+ * @file bsp_planner.h
+ * @brief 运动段队列与前瞻速度规划头文件
+ */
+
+#ifndef __BSP_PLANNER_H
+#define __BSP_PLANNER_H
+
+#include "bsp_motor.h"
+
+// 队列长度(实际可用长度少1)
+#define PLANNER_QUEUE_SIZE          8
+
+// 规划器中的运动段(速度单位为主轴的步/秒)
+typedef struct {
+    StepperBlock_t exec;        // 交给比较中断执行的参数
+    uint32_t nominal_speed;     // 匀速速度
+    uint32_t accel;             // 加速度(主轴的加速度，0表示不加减速)
+    uint32_t max_entry_speed;   // 衔接处允许的最大进入速度
+    uint32_t stop_speed;        // 可以直接启停的速度(各轴速度跳变不超过其启动速度)
+    uint32_t entry_speed;       // 规划后的进入速度
+    uint32_t exit_speed;        // 规划后的退出速度
+} PlannerBlock_t;
+
+// 规划器(一组电机共用一个队列，一个电机即为单轴队列)
+typedef struct {
+    StepperMotor_t* axes[STEPPER_LINEAR_MAX_AXES];   // 参与运动的轴
+    uint8_t axis_count;                               // 轴数
+    uint32_t position[STEPPER_LINEAR_MAX_AXES];      // 队列最后一段的终点(电机位置，含补偿步数)
+    int32_t backlash[STEPPER_LINEAR_MAX_AXES];       // 终点处的补偿步数(电机位置 - 对外位置)
+    PlannerBlock_t blocks[PLANNER_QUEUE_SIZE];        // 运动段环形队列
+    volatile uint8_t head;                            // 写入位置(主循环)
+    volatile uint8_t tail;                            // 读取位置(比较中断)
+    volatile uint8_t running;                         // 队列正在执行
+} Planner_t;
+
+/**
+ * @brief 初始化规划器
+ * @param planner 规划器指针
+ * @param axes 参与运动的电机指针数组(电机应已初始化)
+ * @param count 轴数(不超过STEPPER_LINEAR_MAX_AXES)
+ * @return None
+ */
+void Planner_Init(Planner_t* planner, StepperMotor_t* axes[], uint8_t count);
+
+/**
+ * @brief 添加一段直线运动(绝对位置)
+ * @param planner 规划器指针
+ * @param targets 各轴目标位置(与Stepper_GetPosition相同，不含反向间隙补偿步数)
+ * @param speed 主轴匀速速度(步/秒)，0表示使用主轴的最大速度
+ * @return 1 成功  0 队列已满
+ * @note 电机运行时也可以添加，添加后重新规划队列中各段的衔接速度：
+ *       衔接速度受各轴速度跳变(不超过各轴启动速度)和前后段加减速距离限制，
+ *       正在执行的段和队列第一段的进入速度不再改变。
+ *       有轴反向且设置了反向间隙时，先以同一速度添加一段只有反向轴的补偿段(占用两个位置)
+ */
+uint8_t Planner_Enqueue(Planner_t* planner, const uint32_t targets[], uint32_t speed);
+
+/**
+ * @brief 规划器轮询(在主循环中调用)
+ * @param planner 规划器指针
+ * @return None
+ * @note 电机空闲且队列不为空时启动第一段；运动被停止或限位中断时清空队列
+ */
+void Planner_Poll(Planner_t* planner);
+
+/**
+ * @brief 立即停止并清空队列
+ * @param planner 规划器指针
+ * @return None
+ */
+void Planner_Clear(Planner_t* planner);
+
+/**
+ * @brief 获取队列剩余空间
+ * @param planner 规划器指针
+ * @return 还能添加的段数
+ */
+uint8_t Planner_GetFree(const Planner_t* planner);
+
+#endif // !__BSP_PLANNER_H
@@ -0,0 +1,176 @@
+/**
+ * @file bsp_step_dma.c
+ * @brief DMA脉冲序列输出模块实现文件
+ * @note 每个节拍DMA把缓冲区中的一个字写到GPIO的BSRR，字为0时引脚不变；
+ *       缓冲区分两半，DMA输出一半时在中断中填充另一半，边沿时刻没有中断和抖动
+ */
+
+#include "bsp_step_dma.h"
+
+/* 各端口的双缓冲区 */
+static uint32_t s_step_dma_buf[STEPPER_DMA_PORTS][STEPPER_DMA_HALF * 2];
+static DMA_HandleTypeDef s_step_dma_a;
+static DMA_HandleTypeDef s_step_dma_b;
+
+/**
+ * @brief 填充各端口的半个缓冲区
+ * @param offset 半缓冲区起点(0或STEPPER_DMA_HALF)
+ * @param lead 到这半个缓冲区开始输出还有的节拍数
+ */
+static void StepDma_Fill(uint16_t offset, uint16_t lead)
+{
+    uint32_t* const words[STEPPER_DMA_PORTS] = {
+        &s_step_dma_buf[STEPPER_DMA_PORT_A][offset],
+        &s_step_dma_buf[STEPPER_DMA_PORT_B][offset]
+    };
+
+    Stepper_DmaRender(words, STEPPER_DMA_HALF, (uint32_t)lead << STEPPER_DMA_TICK_SHIFT);
+}
+
+/**
+ * @brief 撤销STEP引脚在缓冲区中还没有输出的边沿
+ * @param port 输出端口(STEPPER_DMA_PORT_x)
+ * @param pin STEP引脚位掩码
+ * @return 已计入位置但被撤销的步数(引脚停在高电平时这一步已输出，少扣一步)
+ * @note 在限位中断中调用，优先级与填充中断相同，不会打断填充。DMA仍在运行，
+ *       即将输出的STEP_DMA_CANCEL_GUARD个字照常输出，从其后开始撤销并补一个复位
+ */
+static int16_t StepDma_Cancel(uint8_t port, uint16_t pin)
+{
+    DMA_Channel_TypeDef* channel = (port == STEPPER_DMA_PORT_A) ? STEP_DMA_CHANNEL_A : STEP_DMA_CHANNEL_B;
+    GPIO_TypeDef* gpio = (port == STEPPER_DMA_PORT_A) ? GPIOA : GPIOB;
+    uint32_t* buf = s_step_dma_buf[port];
+    uint32_t set = pin;
+    uint32_t reset = (uint32_t)pin << 16;
+    uint16_t remain, next, end, i;
+    uint8_t level;
+    int16_t undone = 0;
+
+    /* 两次读到的剩余计数相同，说明读ODR期间没有传输，ODR是next之前各字输出后的电平 */
+    do {
+        remain = (uint16_t)channel->CNDTR;
+        level = (gpio->ODR & pin) ? 1 : 0;
+    } while (remain != (uint16_t)channel->CNDTR);
+    next = STEPPER_DMA_HALF * 2 - remain;
+
+    /* 当前半区剩余部分；另一半的填充中断已处理时另一半也是待输出的数据 */
+    end = (next < STEPPER_DMA_HALF) ? STEPPER_DMA_HALF : STEPPER_DMA_HALF * 2;
+    if (!(DMA1->ISR & ((next < STEPPER_DMA_HALF) ? DMA_ISR_TCIF1 : DMA_ISR_HTIF1))) {
+        end += STEPPER_DMA_HALF;
+    }
+
+    for (i = next; i < end; i++) {
+        uint32_t* word = &buf[i % (STEPPER_DMA_HALF * 2)];
+
+        if (i < next + STEP_DMA_CANCEL_GUARD) {
+            /* 置位优先于复位 */
+            if (*word & reset) {
+                level = 0;
+            }
+            if (*word & set) {
+                level = 1;
+            }
+            continue;
+        }
+        if (*word & reset) {
+            undone++;
+        }
+        *word &= ~(set | reset);
+    }
+
+    /* 停在高电平: 补复位结束这个脉冲(来不及时由下次填充在起点复位) */
+    if (level) {
+        if (next + STEP_DMA_CANCEL_GUARD < end) {
+            buf[(next + STEP_DMA_CANCEL_GUARD) % (STEPPER_DMA_HALF * 2)] |= reset;
+        }
+        undone--;
+    }
+    return undone;
+}
+
+/**
+ * @brief 初始化一个循环DMA通道(内存到GPIO的BSRR)
+ */
+static void StepDma_InitChannel(DMA_HandleTypeDef* hdma, DMA_Channel_TypeDef* channel, uint32_t request)
+{
+    hdma->Instance                 = channel;
+    hdma->Init.Direction           = DMA_MEMORY_TO_PERIPH;
+    hdma->Init.PeriphInc           = DMA_PINC_DISABLE;
+    hdma->Init.MemInc              = DMA_MINC_ENABLE;
+    hdma->Init.PeriphDataAlignment = DMA_PDATAALIGN_WORD;
+    hdma->Init.MemDataAlignment    = DMA_MDATAALIGN_WORD;
+    hdma->Init.Mode                = DMA_CIRCULAR;
+    hdma->Init.Priority            = DMA_PRIORITY_VERY_HIGH;
+
+    HAL_DMA_Init(hdma);
+    HAL_DMA_ChannelMap(hdma, request);
+}
+
+/**
+ * @brief 初始化DMA脉冲序列
+ */
+void bsp_InitStepDma(void)
+{
+    TIM_HandleTypeDef TimHandle = {0};
+
+    STEP_DMA_TIM_CLK_ENABLE();
+    __HAL_RCC_DMA_CLK_ENABLE();
+
+    Stepper_SetDmaCancel(StepDma_Cancel);
+
+    /* 启动前先填好两个半缓冲区 */
+    StepDma_Fill(0, 0);
+    StepDma_Fill(STEPPER_DMA_HALF, STEPPER_DMA_HALF);
+
+    StepDma_InitChannel(&s_step_dma_a, STEP_DMA_CHANNEL_A, STEP_DMA_REQUEST_A);
+    StepDma_InitChannel(&s_step_dma_b, STEP_DMA_CHANNEL_B, STEP_DMA_REQUEST_B);
+
+    HAL_DMA_Start(&s_step_dma_b, (uint32_t)s_step_dma_buf[STEPPER_DMA_PORT_B],
+                  (uint32_t)&GPIOB->BSRR, STEPPER_DMA_HALF * 2);
+    HAL_DMA_Start(&s_step_dma_a, (uint32_t)s_step_dma_buf[STEPPER_DMA_PORT_A],
+                  (uint32_t)&GPIOA->BSRR, STEPPER_DMA_HALF * 2);
+
+    /* 两个通道同步推进，只用通道A的半传输/传输完成中断填充两个端口 */
+    __HAL_DMA_ENABLE_IT(&s_step_dma_a, DMA_IT_HT | DMA_IT_TC);
+    HAL_NVIC_SetPriority(STEP_DMA_IRQn, STEP_DMA_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(STEP_DMA_IRQn);
+
+    /* 不分频，每(1<<STEPPER_DMA_TICK_SHIFT)us更新一次 */
+    TimHandle.Instance = STEP_DMA_TIM;
+    TimHandle.Init.Prescaler         = 0;
+    TimHandle.Init.Period            = ((SystemCoreClock / 1000000) << STEPPER_DMA_TICK_SHIFT) - 1;
+    TimHandle.Init.ClockDivision     = 0;
+    TimHandle.Init.CounterMode       = TIM_COUNTERMODE_UP;
+    TimHandle.Init.RepetitionCounter = 0;
+    TimHandle.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+
+    if (HAL_TIM_Base_Init(&TimHandle) != HAL_OK) {
+        printf("Step DMA timer init error\r\n");
+        return;
+    }
+
+    /* 比较通道1在计数器回到0时匹配，与更新事件同一节拍 */
+    STEP_DMA_TIM->CCR1 = 0;
+    __HAL_TIM_ENABLE_DMA(&TimHandle, TIM_DMA_UPDATE | TIM_DMA_CC1);
+    HAL_TIM_Base_Start(&TimHandle);
+}
+
+/**
+ * @brief DMA通道1中断: 已输出的半缓冲区重新填充
+ */
+void DMA1_Channel1_IRQHandler(void)
+{
+    uint32_t isr = DMA1->ISR;
+    uint16_t remain = (uint16_t)STEP_DMA_CHANNEL_A->CNDTR;
+
+    /* 剩余计数是到缓冲区末尾的节拍数 */
+    if (isr & DMA_ISR_HTIF1) {
+        DMA1->IFCR = DMA_IFCR_CHTIF1;
+        StepDma_Fill(0, remain);
+    }
+
+    if (isr & DMA_ISR_TCIF1) {
+        DMA1->IFCR = DMA_IFCR_CTCIF1;
+        StepDma_Fill(STEPPER_DMA_HALF, (remain > STEPPER_DMA_HALF) ? remain - STEPPER_DMA_HALF : 0);
+    }
+}
@@ -0,0 +1,34 @@
+/**
+ * @file bsp_step_dma.h
+ * @brief DMA脉冲序列输出模块头文件
+ */
+
+#ifndef __BSP_STEP_DMA_H
+#define __BSP_STEP_DMA_H
+
+#include "bsp_motor.h"
+
+// 节拍定时器: 更新事件请求端口A的DMA通道，比较通道1(CCR1=0)请求端口B的DMA通道，
+// 两个通道在同一节拍各写一个字到GPIOA/GPIOB的BSRR
+#define STEP_DMA_TIM                TIM16
+#define STEP_DMA_TIM_CLK_ENABLE()   __HAL_RCC_TIM16_CLK_ENABLE()
+#define STEP_DMA_CHANNEL_A          DMA1_Channel1
+#define STEP_DMA_CHANNEL_B          DMA1_Channel2
+#define STEP_DMA_REQUEST_A          DMA_CHANNEL_MAP_TIM16_UP
+#define STEP_DMA_REQUEST_B          DMA_CHANNEL_MAP_TIM16_CH1
+#define STEP_DMA_IRQn               DMA1_Channel1_IRQn
+#define STEP_DMA_IRQ_PRIORITY       1       // 填充中断优先级(限位中断应与之相同)
+
+// 撤销边沿时跳过即将输出的字数(撤销过程中DMA仍在传输)
+#define STEP_DMA_CANCEL_GUARD       2
+
+/**
+ * @brief 初始化DMA脉冲序列(节拍定时器和两个循环DMA通道)
+ * @return 无
+ * @note 电机用Stepper_AttachDma指定输出端口和STEP引脚后由本模块输出脉冲；
+ *       半缓冲区输出完时在DMA中断中填充，填充耗时与边沿数成正比，
+ *       必须在半缓冲区时长(STEPPER_DMA_HALF个节拍)内完成
+ */
+void bsp_InitStepDma(void);
+
+#endif // !__BSP_STEP_DMA_H
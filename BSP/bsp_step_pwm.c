@@ -0,0 +1,294 @@
+/**
+ * @file bsp_step_pwm.c
+ * @brief 匀速段硬件PWM输出模块实现文件
+ * @note PWM定时器按PWM模式2输出，每个周期先低后高，更新事件在脉冲下降沿；
+ *       计数定时器与之同时钟，分频等于步周期，更新事件落在每个脉冲之后低电平的中间，
+ *       在计数中断中切换引脚、设置最后一步和收尾，中断有半个低电平的响应时间。
+ *       PWM定时器的计数值是到上一个下降沿的时间(第一个脉冲之前按虚拟的下降沿起算)
+ */
+
+#include "bsp_step_pwm.h"
+
+/* 引脚模式(MODER) */
+#define STEP_PWM_MODER_OUTPUT       1U
+#define STEP_PWM_MODER_AF           2U
+
+/* 计数中断状态 */
+#define STEP_PWM_IDLE               0   // 空闲
+#define STEP_PWM_ARMED              1   // 等待第一个脉冲之前的低电平中间，引脚还是普通输出
+#define STEP_PWM_RUN                2   // 引脚已切换为PWM输出，计数到倒数第二步
+#define STEP_PWM_LAST               3   // 最后一个周期结束时PWM定时器自动停止
+
+static StepperMotor_t* s_pwm_motor = NULL;
+static GPIO_TypeDef* s_pwm_port = NULL;
+static uint16_t s_pwm_pin = 0;
+static uint8_t s_pwm_index = 0;
+static uint32_t s_pwm_clk = 48;         // 每us的时钟数
+static volatile uint8_t s_pwm_state = STEP_PWM_IDLE;
+static uint32_t s_pwm_steps = 0;        // 本次输出的步数
+static uint32_t s_pwm_period = 0;       // 步周期(us，取整)
+static uint32_t s_pwm_cycles = 0;       // 步周期(时钟数)
+static uint32_t s_pwm_half = 0;         // 计数更新在下降沿之后的时钟数(约为低电平的一半)
+
+/**
+ * @brief 切换STEP引脚模式(普通输出时引脚电平由ODR决定)
+ */
+static void StepPwm_PinMode(uint32_t mode)
+{
+    uint32_t shift = (uint32_t)s_pwm_index * 2;
+
+    s_pwm_port->MODER = (s_pwm_port->MODER & ~(3U << shift)) | (mode << shift);
+}
+
+/**
+ * @brief 引脚切回普通输出并停止两个定时器
+ */
+static void StepPwm_Halt(void)
+{
+    StepPwm_PinMode(STEP_PWM_MODER_OUTPUT);
+    STEP_PWM_TIM->CR1 = 0;
+    STEP_PWM_CNT_TIM->CR1 = 0;
+    STEP_PWM_CNT_TIM->DIER = 0;
+    STEP_PWM_CNT_TIM->SR = 0;
+    s_pwm_state = STEP_PWM_IDLE;
+}
+
+/**
+ * @brief steps个步周期的时长(us，四舍五入)
+ */
+static uint32_t StepPwm_Span(uint32_t steps)
+{
+    return (steps * s_pwm_cycles + (s_pwm_clk >> 1)) / s_pwm_clk;
+}
+
+/**
+ * @brief 从现在起lead后输出第一步，之后每period(Q8，us)一步，共steps步
+ * @return 第一步到这些步之后下一步的时间(us)，0为忙、周期超出范围或来不及切换引脚
+ * @note 步周期取最接近的时钟数，误差不超过半个时钟
+ */
+static uint32_t StepPwm_Start(StepperMotor_t* motor, uint32_t lead, uint32_t period, uint32_t steps)
+{
+    uint32_t p, h, l, t0;
+
+    if (motor != s_pwm_motor || s_pwm_state != STEP_PWM_IDLE || steps < 3 ||
+        period < (STEP_PWM_MIN_PERIOD_US << 8) || period > (STEP_PWM_MAX_PERIOD_US << 8)) {
+        return 0;
+    }
+
+    /* 高电平与边沿路径相同为整数步周期的一半，低电平为其余部分 */
+    p = (period * s_pwm_clk + 0x80) >> 8;
+    h = (period >> 9) * s_pwm_clk;
+    l = p - h;
+    lead *= s_pwm_clk;
+    lead = (lead > STEP_PWM_START_CYCLES) ? lead - STEP_PWM_START_CYCLES : 0;
+
+    /* 第一次计数中断在第一个脉冲之前的低电平中间(至少1us后)，分两个节拍所以取偶数 */
+    if (lead < (l >> 1) + s_pwm_clk || lead + h > 0x10000) {
+        return 0;
+    }
+    t0 = (lead - (l >> 1)) & ~1U;
+
+    /* PWM定时器: 提前时间不超过低电平时从周期中间开始，否则第一个周期单独设置 */
+    STEP_PWM_TIM->CR1 = 0;
+    STEP_PWM_TIM->PSC = 0;
+    if (lead <= l) {
+        STEP_PWM_TIM->ARR = p - 1;
+        STEP_PWM_TIM->CCR1 = l;
+        STEP_PWM_TIM->EGR = TIM_EGR_UG;
+        STEP_PWM_TIM->CR1 = TIM_CR1_ARPE;
+        STEP_PWM_TIM->CNT = l - lead;
+    } else {
+        STEP_PWM_TIM->ARR = lead + h - 1;
+        STEP_PWM_TIM->CCR1 = lead;
+        STEP_PWM_TIM->EGR = TIM_EGR_UG;
+        STEP_PWM_TIM->CR1 = TIM_CR1_ARPE;
+        STEP_PWM_TIM->ARR = p - 1;
+        STEP_PWM_TIM->CCR1 = l;
+    }
+    STEP_PWM_TIM->SR = 0;
+
+    /* 计数定时器: 第一次更新在t0，之后每个步周期一次 */
+    STEP_PWM_CNT_TIM->CR1 = 0;
+    STEP_PWM_CNT_TIM->ARR = 1;
+    STEP_PWM_CNT_TIM->PSC = (t0 >> 1) - 1;
+    STEP_PWM_CNT_TIM->EGR = TIM_EGR_UG;
+    STEP_PWM_CNT_TIM->PSC = p - 1;
+    STEP_PWM_CNT_TIM->SR = 0;
+    STEP_PWM_CNT_TIM->DIER = TIM_DIER_UIE;
+
+    s_pwm_steps = steps;
+    s_pwm_period = period >> 8;
+    s_pwm_cycles = p;
+    s_pwm_half = l - (lead - t0);
+    s_pwm_state = STEP_PWM_ARMED;
+
+    __disable_irq();
+    STEP_PWM_TIM->CR1 |= TIM_CR1_CEN;
+    STEP_PWM_CNT_TIM->CR1 |= TIM_CR1_CEN;
+    __enable_irq();
+    return StepPwm_Span(steps);
+}
+
+/**
+ * @brief 尽早结束，新的最后一步至少在STEP_PWM_CUT_LEAD_US之后
+ * @param early 结束提前的时间(us)，与开始时返回的时长按同样方式取整
+ * @return 从末尾去掉的步数，来不及时返回0
+ * @note 在临界区中调用
+ */
+static uint32_t StepPwm_Cut(StepperMotor_t* motor, uint32_t* early)
+{
+    uint32_t margin = (STEP_PWM_CUT_LEAD_US + s_pwm_period - 1) / s_pwm_period + 2;
+    uint32_t done, steps;
+
+    if (motor != s_pwm_motor) {
+        return 0;
+    }
+
+    switch (s_pwm_state) {
+        case STEP_PWM_ARMED:
+            done = 0;
+            break;
+
+        case STEP_PWM_RUN:
+            /* 计数中断未处理时已经到倒数第二步 */
+            if (STEP_PWM_CNT_TIM->SR & TIM_SR_UIF) {
+                return 0;
+            }
+            done = STEP_PWM_CNT_TIM->CNT;
+            break;
+
+        default:
+            return 0;
+    }
+
+    steps = (done + margin > 3) ? done + margin : 3;
+    if (steps >= s_pwm_steps) {
+        return 0;
+    }
+
+    if (s_pwm_state == STEP_PWM_RUN) {
+        STEP_PWM_CNT_TIM->ARR = steps - 2;
+    }
+    done = s_pwm_steps - steps;
+    *early = StepPwm_Span(s_pwm_steps) - StepPwm_Span(steps);
+    s_pwm_steps = steps;
+    return done;
+}
+
+/**
+ * @brief 立即停止，引脚切回普通输出
+ * @return 还没有输出的步数(引脚正在高电平的一步算作已输出)
+ * @note 在临界区中调用
+ */
+static uint32_t StepPwm_Cancel(StepperMotor_t* motor)
+{
+    uint32_t ticks, sr, since, done = 0;
+    uint8_t high;
+
+    if (motor != s_pwm_motor || s_pwm_state == STEP_PWM_IDLE) {
+        return 0;
+    }
+
+    /* 引脚切换为PWM输出之前没有输出任何一步 */
+    if (s_pwm_state != STEP_PWM_ARMED) {
+        do {
+            ticks = STEP_PWM_CNT_TIM->CNT;
+            sr = STEP_PWM_CNT_TIM->SR;
+            since = STEP_PWM_TIM->CNT;
+            high = (s_pwm_port->IDR & s_pwm_pin) ? 1 : 0;
+        } while (ticks != STEP_PWM_CNT_TIM->CNT);
+
+        /* 计数节拍数: 倒数第二步之后计数值被置为ARR，下一个节拍为最后一次更新 */
+        if (s_pwm_state == STEP_PWM_RUN) {
+            ticks += (sr & TIM_SR_UIF) ? s_pwm_steps - 1 : 0;
+        } else {
+            ticks = s_pwm_steps - 1 + ((sr & TIM_SR_UIF) ? 1 : 0);
+        }
+
+        /* 本节拍内已经过下降沿: 到上一个下降沿的时间小于更新事件的偏移 */
+        done = ticks + ((since < s_pwm_half) ? 1 : 0) + high;
+        if (done > s_pwm_steps) {
+            done = s_pwm_steps;
+        }
+    }
+
+    StepPwm_Halt();
+    return s_pwm_steps - done;
+}
+
+static const StepperPwmOps_t s_step_pwm_ops = {
+    StepPwm_Start,
+    StepPwm_Cut,
+    StepPwm_Cancel
+};
+
+/**
+ * @brief 初始化匀速段PWM输出
+ */
+void bsp_InitStepPwm(StepperMotor_t* motor, GPIO_TypeDef* port, uint16_t pin, uint8_t af)
+{
+    uint8_t index = 0;
+
+    while (index < 15 && !(pin & (1U << index))) {
+        index++;
+    }
+
+    STEP_PWM_TIM_CLK_ENABLE();
+    STEP_PWM_CNT_TIM_CLK_ENABLE();
+
+    s_pwm_motor = motor;
+    s_pwm_port = port;
+    s_pwm_pin = pin;
+    s_pwm_index = index;
+    s_pwm_clk = SystemCoreClock / 1000000;
+    s_pwm_state = STEP_PWM_IDLE;
+
+    /* 先写好复用功能号，输出时只切换引脚模式 */
+    port->AFR[index >> 3] = (port->AFR[index >> 3] & ~(0xFU << ((index & 7) * 4))) |
+                            ((uint32_t)af << ((index & 7) * 4));
+
+    /* PWM模式2: 计数值小于CCR1时低电平；比较值预装载，更新事件时生效 */
+    STEP_PWM_TIM->CR1 = 0;
+    STEP_PWM_TIM->CCMR1 = TIM_CCMR1_OC1M_2 | TIM_CCMR1_OC1M_1 | TIM_CCMR1_OC1M_0 | TIM_CCMR1_OC1PE;
+    STEP_PWM_TIM->CCER = TIM_CCER_CC1E;
+
+    STEP_PWM_CNT_TIM->CR1 = 0;
+    STEP_PWM_CNT_TIM->DIER = 0;
+    HAL_NVIC_SetPriority(STEP_PWM_CNT_IRQn, STEP_PWM_CNT_IRQ_PRIORITY, 0);
+    HAL_NVIC_EnableIRQ(STEP_PWM_CNT_IRQn);
+
+    Stepper_AttachPwm(motor, &s_step_pwm_ops);
+}
+
+/**
+ * @brief 计数定时器中断: 每个脉冲之后低电平的中间
+ */
+void TIM17_IRQHandler(void)
+{
+    STEP_PWM_CNT_TIM->SR = (uint16_t)~TIM_SR_UIF;
+
+    switch (s_pwm_state) {
+        case STEP_PWM_ARMED:
+            /* 上一步的边沿已经输出，引脚交给PWM；下一次更新在倒数第二步之后 */
+            StepPwm_PinMode(STEP_PWM_MODER_AF);
+            STEP_PWM_CNT_TIM->ARR = s_pwm_steps - 2;
+            s_pwm_state = STEP_PWM_RUN;
+            break;
+
+        case STEP_PWM_RUN:
+            /* 单脉冲模式: 最后一个周期结束(下降沿)时PWM定时器停止，计数定时器再过一个节拍收尾 */
+            STEP_PWM_TIM->CR1 |= TIM_CR1_OPM;
+            STEP_PWM_CNT_TIM->CNT = STEP_PWM_CNT_TIM->ARR;
+            s_pwm_state = STEP_PWM_LAST;
+            break;
+
+        case STEP_PWM_LAST:
+            StepPwm_Halt();
+            Stepper_PwmDone(s_pwm_motor);
+            break;
+
+        default:
+            StepPwm_Halt();
+            break;
+    }
+}
@@ -0,0 +1,44 @@
+/**
+ * @file bsp_step_pwm.h
+ * @brief 匀速段硬件PWM输出模块头文件
+ */
+
+#ifndef __BSP_STEP_PWM_H
+#define __BSP_STEP_PWM_H
+
+#include "bsp_motor.h"
+
+// PWM定时器: TIM14_CH1输出STEP脉冲(PA4复用AF4，步进引脚中只有PA4不在TIM1上)
+#define STEP_PWM_TIM                TIM14
+#define STEP_PWM_TIM_CLK_ENABLE()   __HAL_RCC_TIM14_CLK_ENABLE()
+
+// 计数定时器: TIM14没有从模式，TIM17与TIM14同时钟同时启动，分频等于步周期，
+// 每个脉冲之后的低电平中间产生一次更新事件
+#define STEP_PWM_CNT_TIM            TIM17
+#define STEP_PWM_CNT_TIM_CLK_ENABLE() __HAL_RCC_TIM17_CLK_ENABLE()
+#define STEP_PWM_CNT_IRQn           TIM17_IRQn
+#define STEP_PWM_CNT_IRQ_PRIORITY   0       // 计数中断应在半个低电平内响应
+
+// 步周期范围(us): 下限留出计数中断的响应时间，上限受16位计数器限制
+#define STEP_PWM_MIN_PERIOD_US      20
+#define STEP_PWM_MAX_PERIOD_US      1000
+
+// 启动时写寄存器到定时器开始计数的时钟数，从第一个脉冲的提前时间中扣除
+#define STEP_PWM_START_CYCLES       64
+
+// 截短时新的结束点至少在此时间之后(us): DMA脉冲序列最多提前两个半缓冲区生成
+#define STEP_PWM_CUT_LEAD_US        ((2 * STEPPER_DMA_HALF << STEPPER_DMA_TICK_SHIFT) + 64)
+
+/**
+ * @brief 初始化匀速段PWM输出并交给电机使用
+ * @param motor 步进电机结构体指针(STEP引脚应已配置为推挽输出)
+ * @param port STEP引脚端口
+ * @param pin STEP引脚(GPIO_PIN_x)
+ * @param af 引脚复用为STEP_PWM_TIM通道1的复用功能号
+ * @return 无
+ * @note 只有一路PWM，同一时刻只有一个电机的匀速段由PWM输出。引脚平时为普通输出，
+ *       PWM输出期间切换为复用功能，完成、截短到末尾或撤销后切换回普通输出(低电平)
+ */
+void bsp_InitStepPwm(StepperMotor_t* motor, GPIO_TypeDef* port, uint16_t pin, uint8_t af);
+
+#endif // !__BSP_STEP_PWM_H
@@ -0,0 +1,103 @@
+/**
+ * @file bsp_timebase.c
+ * @brief 微秒时间基准模块实现文件
+ * @note SysTick只保留1kHz节拍(HAL_IncTick和软件定时器)，微秒时间直接读取
+ *       自由运行的16位定时器计数器，高位由溢出中断累加
+ */
+
+#include "bsp_timebase.h"
+
+/* 计数器溢出次数(时间的高位) */
+static volatile uint32_t s_timebase_overflow = 0;
+static uint8_t s_timebase_ready = 0;
+
+/**
+ * @brief 初始化时间基准定时器
+ */
+void bsp_InitTimebase(void)
+{
+    TIM_HandleTypeDef TimHandle = {0};
+
+    if (s_timebase_ready) {
+        return;
+    }
+
+    TIMEBASE_TIM_CLK_ENABLE();
+
+    /* 分频后计数器计1次为1us，计满0xFFFF回绕 */
+    TimHandle.Instance = TIMEBASE_TIM;
+    TimHandle.Init.Prescaler         = SystemCoreClock / 1000000 - 1;
+    TimHandle.Init.Period            = 0xFFFF;
+    TimHandle.Init.ClockDivision     = 0;
+    TimHandle.Init.CounterMode       = TIM_COUNTERMODE_UP;
+    TimHandle.Init.RepetitionCounter = 0;
+    TimHandle.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
+
+    if (HAL_TIM_Base_Init(&TimHandle) != HAL_OK) {
+        printf("HAL_TIM_Base_Init error\n");
+        return;
+    }
+
+    /* 初始化时产生的更新事件不计入溢出 */
+    s_timebase_overflow = 0;
+    TIMEBASE_TIM->SR = (uint16_t)~TIM_IT_UPDATE;
+    TIMEBASE_TIM->DIER |= TIM_IT_UPDATE;
+
+    HAL_TIM_Base_Start(&TimHandle);
+    s_timebase_ready = 1;
+}
+
+/**
+ * @brief 计数器溢出处理
+ */
+void bsp_TimebaseOverflow(void)
+{
+    s_timebase_overflow++;
+}
+
+/**
+ * @brief 读取溢出次数和计数器的一致快照
+ * @param cnt 返回计数器值
+ * @return 溢出次数
+ * @note M0+没有64位原子读，关中断读取；如果溢出已发生但中断还未处理
+ *       (在更高优先级中断或关中断时调用)，由UIF标志补偿
+ */
+static uint32_t bsp_TimebaseSnapshot(uint16_t *cnt)
+{
+    uint32_t primask = __get_PRIMASK();
+    uint32_t high;
+    uint16_t low;
+
+    __disable_irq();
+    high = s_timebase_overflow;
+    low = (uint16_t)TIMEBASE_TIM->CNT;
+    if ((TIMEBASE_TIM->SR & TIM_IT_UPDATE) && low < 0x8000) {
+        high++;
+    }
+    __set_PRIMASK(primask);
+
+    *cnt = low;
+    return high;
+}
+
+/**
+ * @brief 获取32位微秒时间
+ */
+uint32_t bsp_GetTimeUs(void)
+{
+    uint16_t cnt;
+    uint32_t high = bsp_TimebaseSnapshot(&cnt);
+
+    return (high << 16) | cnt;
+}
+
+/**
+ * @brief 获取64位微秒时间
+ */
+uint64_t bsp_GetTimeUs64(void)
+{
+    uint16_t cnt;
+    uint32_t high = bsp_TimebaseSnapshot(&cnt);
+
+    return ((uint64_t)high << 16) | cnt;
+}
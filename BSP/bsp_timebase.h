@@ -0,0 +1,42 @@
+/**
+ * @file bsp_timebase.h
+ * @brief 微秒时间基准模块头文件
+ */
+
+#ifndef __BSP_TIMEBASE_H
+#define __BSP_TIMEBASE_H
+
+#include "main.h"
+
+// 时间基准定时器(16位自由运行计数器，1MHz，溢出中断扩展为32/64位)
+// 与 hardware_timr.c 的单次定时共用同一个计数器
+#define TIMEBASE_TIM                TIM3
+#define TIMEBASE_TIM_CLK_ENABLE()   __HAL_RCC_TIM3_CLK_ENABLE()
+
+/**
+ * @brief 初始化时间基准定时器(可重复调用，只初始化一次)
+ * @return 无
+ */
+void bsp_InitTimebase(void);
+
+/**
+ * @brief 获取32位微秒时间(约71.6分钟回绕，用无符号减法计算时间差)
+ * @return 当前时间(us)
+ * @note 可在主循环和任意中断中调用，读数不会撕裂
+ */
+uint32_t bsp_GetTimeUs(void);
+
+/**
+ * @brief 获取64位微秒时间
+ * @return 当前时间(us)
+ * @note 可在主循环和任意中断中调用，读数不会撕裂
+ */
+uint64_t bsp_GetTimeUs64(void);
+
+/**
+ * @brief 计数器溢出处理，由定时器中断函数调用
+ * @return 无
+ */
+void bsp_TimebaseOverflow(void);
+
+#endif /* __BSP_TIMEBASE_H */
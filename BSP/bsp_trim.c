@@ -0,0 +1,190 @@
+/**
+ * @file bsp_trim.c
+ * @brief 速度微调闭环(CMSIS-DSP Q15 PID，固定周期采样)
+ * @note TIM3比较通道按TRIM_PERIOD_US固定周期中断，中断中只读取反馈、计算arm_pid_q15并
+ *       保存速度命令；主循环轮询到新的速度命令后用Stepper_Jog交给电机(重新规划有64位除法，
+ *       并且要与脉冲中断的段填充互斥，不在TIM3的0级中断里做)。依赖bsp_InitHardTimer已调用。
+ *       同一时刻只能运行一个闭环
+ */
+
+#include "bsp_trim.h"
+#include "hardware_timr.h"
+
+#define TRIM_ENTER_CRITICAL()   uint32_t _primask = __get_PRIMASK(); __disable_irq()
+#define TRIM_EXIT_CRITICAL()    __set_PRIMASK(_primask)
+
+// 占用定时通道的闭环
+static Trim_t* volatile s_trim = NULL;
+
+// 私有函数声明
+static void Trim_Tick(void);
+static void Trim_Release(Trim_t* trim);
+
+/**
+ * @brief 初始化速度微调闭环
+ */
+void Trim_Init(Trim_t* trim, StepperMotor_t* motor, TrimFeedbackFunc_t feedback, void* user)
+{
+    trim->motor = motor;
+    trim->feedback = feedback;
+    trim->user = user;
+    trim->pid.Kp = 0;
+    trim->pid.Ki = 0;
+    trim->pid.Kd = 0;
+    arm_pid_init_q15(&trim->pid, 1);
+    trim->setpoint = 0;
+    trim->base_speed = 0;
+    trim->range = 0;
+    trim->measured = 0;
+    trim->output = 0;
+    trim->command = 0;
+    trim->ticks = 0;
+    trim->applied_ticks = 0;
+    trim->applied = 0;
+    trim->running = 0;
+    trim->halted = 0;
+}
+
+/**
+ * @brief 设置PID增益
+ */
+void Trim_SetGains(Trim_t* trim, q15_t kp, q15_t ki, q15_t kd)
+{
+    // 系数要与控制周期中断一次性更新
+    TRIM_ENTER_CRITICAL();
+    trim->pid.Kp = kp;
+    trim->pid.Ki = ki;
+    trim->pid.Kd = kd;
+    arm_pid_init_q15(&trim->pid, 0);
+    TRIM_EXIT_CRITICAL();
+}
+
+/**
+ * @brief 启动闭环
+ */
+uint8_t Trim_Start(Trim_t* trim, q15_t setpoint, int32_t base_speed, int32_t range)
+{
+    if (s_trim != NULL && s_trim != trim) {
+        return 0;
+    }
+    bsp_StopHardTimer(TRIM_TIMER_CC);
+
+    if (range < 0) {
+        range = 0;
+    } else if (range > TRIM_RANGE_MAX) {
+        range = TRIM_RANGE_MAX;
+    }
+
+    arm_pid_init_q15(&trim->pid, 1);
+    trim->setpoint = setpoint;
+    trim->base_speed = base_speed;
+    trim->range = range;
+    trim->measured = 0;
+    trim->output = 0;
+    trim->command = base_speed;
+    trim->ticks = 0;
+    trim->applied_ticks = 0;
+    trim->halted = 0;
+
+    // PID输出从零开始，先按基准速度运行
+    trim->applied = base_speed;
+    Stepper_Jog(trim->motor, base_speed);
+
+    trim->running = 1;
+    s_trim = trim;
+    bsp_StartHardTimer(TRIM_TIMER_CC, TRIM_PERIOD_US, Trim_Tick);
+    return 1;
+}
+
+/**
+ * @brief 停止闭环
+ */
+void Trim_Stop(Trim_t* trim, uint8_t immediate)
+{
+    if (!trim->running) {
+        return;
+    }
+    Trim_Release(trim);
+    trim->applied = 0;
+    Stepper_Stop(trim->motor, immediate);
+}
+
+/**
+ * @brief 运行中修改给定值和基准速度
+ */
+void Trim_SetTarget(Trim_t* trim, q15_t setpoint, int32_t base_speed)
+{
+    trim->setpoint = setpoint;
+    trim->base_speed = base_speed;
+}
+
+/**
+ * @brief 闭环轮询
+ */
+void Trim_Poll(Trim_t* trim)
+{
+    StepperMotor_t* motor = trim->motor;
+    uint32_t ticks;
+    int32_t command;
+
+    if (!trim->running) {
+        return;
+    }
+
+    // 按非零速度运行后停下且没有等待反向启动: 被限位或停止命令停下
+    if (trim->applied != 0 && motor->state == STEPPER_STATE_IDLE &&
+        motor->retarget_pending == 0) {
+        Trim_Release(trim);
+        trim->halted = 1;
+        return;
+    }
+
+    ticks = trim->ticks;
+    if (ticks == trim->applied_ticks) {
+        return;
+    }
+    trim->applied_ticks = ticks;
+
+    command = trim->command;
+    if (command == trim->applied) {
+        return;
+    }
+    trim->applied = command;
+    Stepper_Jog(motor, command);
+}
+
+/**
+ * @brief 控制周期中断回调(TIM3比较中断)
+ * @note 从上一次到期时刻重新定时，采样周期固定；误差饱和到Q15后送入PID
+ */
+static void Trim_Tick(void)
+{
+    Trim_t* trim = s_trim;
+    int32_t error;
+    q15_t out;
+
+    if (trim == NULL) {
+        return;
+    }
+    bsp_RestartHardTimer(TRIM_TIMER_CC, TRIM_PERIOD_US);
+
+    trim->measured = trim->feedback(trim);
+    error = (int32_t)trim->setpoint - trim->measured;
+    out = arm_pid_q15(&trim->pid, (q15_t)__SSAT(error, 16));
+
+    trim->output = out;
+    trim->command = trim->base_speed + ((out * trim->range) >> 15);
+    trim->ticks++;
+}
+
+/**
+ * @brief 退出闭环并释放定时通道(电机不动)
+ */
+static void Trim_Release(Trim_t* trim)
+{
+    bsp_StopHardTimer(TRIM_TIMER_CC);
+    trim->running = 0;
+    if (s_trim == trim) {
+        s_trim = NULL;
+    }
+}
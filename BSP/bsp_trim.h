@@ -0,0 +1,105 @@
+/**
+ * @file bsp_trim.h
+ * @brief 速度微调闭环头文件(CMSIS-DSP Q15 PID，固定周期采样)
+ */
+
+#ifndef __BSP_TRIM_H
+#define __BSP_TRIM_H
+
+#include "bsp_motor.h"
+#include "arm_math.h"
+
+// 控制周期: 使用hardware_timr的TIM3比较通道定时(通道1由Modbus帧间隔使用)
+#define TRIM_TIMER_CC           2
+#define TRIM_PERIOD_US          500     // 控制周期(us)，2kHz
+#define TRIM_RANGE_MAX          65535   // PID满量程输出对应的最大速度修正(步/秒)
+
+struct Trim;
+
+/**
+ * @brief 反馈读取函数(在TIM3中断中每个控制周期调用一次)
+ * @param trim 闭环指针
+ * @return 测量值(Q15)，应与给定值使用相同的标定
+ * @note 只读取已经转换好的数据(ADC的DMA缓冲、编码器计数等)，不要在这里等待转换
+ */
+typedef q15_t (*TrimFeedbackFunc_t)(struct Trim* trim);
+
+// 速度微调闭环: 定时中断计算PID并给出速度命令，主循环把速度命令交给电机
+typedef struct Trim {
+    StepperMotor_t* motor;          // 电机
+    TrimFeedbackFunc_t feedback;    // 反馈读取函数
+    void* user;                     // 反馈函数使用的用户数据
+    arm_pid_instance_q15 pid;       // PID实例(Kp/Ki/Kd为每个控制周期的离散增益)
+    volatile q15_t setpoint;        // 给定值(Q15)
+    volatile int32_t base_speed;    // 基准速度(步/秒，负值为逆时针)
+    volatile int32_t range;         // PID输出为+1.0时的速度修正(步/秒)
+    volatile q15_t measured;        // 最近一次测量值
+    volatile q15_t output;          // 最近一次PID输出
+    volatile int32_t command;       // 最近一次计算的速度命令(步/秒)
+    volatile uint32_t ticks;        // 已执行的控制周期数
+    uint32_t applied_ticks;         // 最近一次交给电机的控制周期
+    int32_t applied;                // 最近一次交给电机的速度命令
+    volatile uint8_t running;       // 闭环运行中
+    uint8_t halted;                 // 电机被限位或停止命令停下，闭环已退出
+} Trim_t;
+
+/**
+ * @brief 初始化速度微调闭环
+ * @param trim 闭环指针
+ * @param motor 电机指针(应已初始化并设置加速度和最大速度)
+ * @param feedback 反馈读取函数
+ * @param user 反馈函数使用的用户数据
+ * @return None
+ */
+void Trim_Init(Trim_t* trim, StepperMotor_t* motor, TrimFeedbackFunc_t feedback, void* user);
+
+/**
+ * @brief 设置PID增益
+ * @param trim 闭环指针
+ * @param kp 比例增益(Q15)
+ * @param ki 积分增益(Q15)，连续域积分增益乘以控制周期
+ * @param kd 微分增益(Q15)，连续域微分增益除以控制周期
+ * @return None
+ * @note 运行中可以调用，积分状态保留。增益都小于1.0，更大的环路增益由Trim_Start的range给出
+ */
+void Trim_SetGains(Trim_t* trim, q15_t kp, q15_t ki, q15_t kd);
+
+/**
+ * @brief 启动闭环(不阻塞)
+ * @param trim 闭环指针
+ * @param setpoint 给定值(Q15)
+ * @param base_speed 基准速度(步/秒，负值为逆时针)
+ * @param range PID输出为+1.0时的速度修正(步/秒)，最大TRIM_RANGE_MAX
+ * @return 1 已启动  0 定时通道已被其他闭环占用
+ * @note 速度命令 = base_speed + PID输出 * range，误差 = 给定值 - 测量值。
+ *       PID从零状态开始，电机按加速度从当前速度过渡到速度命令
+ */
+uint8_t Trim_Start(Trim_t* trim, q15_t setpoint, int32_t base_speed, int32_t range);
+
+/**
+ * @brief 停止闭环
+ * @param trim 闭环指针
+ * @param immediate 1 电机立即停止  0 电机减速停止
+ * @return None
+ */
+void Trim_Stop(Trim_t* trim, uint8_t immediate);
+
+/**
+ * @brief 运行中修改给定值和基准速度
+ * @param trim 闭环指针
+ * @param setpoint 给定值(Q15)
+ * @param base_speed 基准速度(步/秒)
+ * @return None
+ */
+void Trim_SetTarget(Trim_t* trim, q15_t setpoint, int32_t base_speed);
+
+/**
+ * @brief 闭环轮询(在主循环中调用)
+ * @param trim 闭环指针
+ * @return None
+ * @note 有新的控制周期结果且速度命令变化时调用Stepper_Jog；电机被限位或停止命令
+ *       停下时闭环退出并置halted
+ */
+void Trim_Poll(Trim_t* trim);
+
+#endif // !__BSP_TRIM_H
@@ -13,48 +13,17 @@ static void (*s_TIM_CallBack4)(void);
  */
 void bsp_InitHardTimer(void)
 {
-    TIM_HandleTypeDef  TimHandle = {0};
-	uint32_t usPeriod;
-	uint16_t usPrescaler;
-	uint32_t uiTIMxCLK;
-	
-    __HAL_RCC_TIM3_CLK_ENABLE();
-	
-	uiTIMxCLK = SystemCoreClock;
-
-	usPrescaler = uiTIMxCLK / 1000000 - 1;	/* 分频比 = 1 */
-	
-
-    usPeriod = 0xFFFF;
-	
-
 	/* 
-       设置分频为usPrescaler后，那么定时器计数器计1次就是1us
-       而参数usPeriod的值是决定了最大计数：
-       usPeriod = 0xFFFF 表示最大0xFFFF微秒。
-       usPeriod = 0xFFFFFFFF 表示最大0xFFFFFFFF微秒。
+       计数器由时间基准模块初始化，计数器计1次就是1us，最大计数0xFFFF，
+       单次定时和bsp_GetTimeUs()使用同一个计数器
     */
-	TimHandle.Instance = TIM3;
-	TimHandle.Init.Prescaler         = usPrescaler;
-	TimHandle.Init.Period            = usPeriod;
-	TimHandle.Init.ClockDivision     = 0;
-	TimHandle.Init.CounterMode       = TIM_COUNTERMODE_UP;
-	TimHandle.Init.RepetitionCounter = 0;
-    TimHandle.Init.AutoReloadPreload = TIM_AUTORELOAD_PRELOAD_ENABLE;
-	
-	if (HAL_TIM_Base_Init(&TimHandle) != HAL_OK)
-	{
-        printf("HAL_TIM_Base_Init error\n");
-	}
+	bsp_InitTimebase();
 
-	/* 配置定时器中断，给CC捕获比较中断使用 */
+	/* 配置定时器中断，给CC捕获比较中断和计数器溢出使用 */
 	{
 		HAL_NVIC_SetPriority(TIM3_IRQn, 0, 2);
 		HAL_NVIC_EnableIRQ(TIM3_IRQn);
 	}
-    
-    /* 启动定时器 */
-	HAL_TIM_Base_Start(&TimHandle);
 }
 
 /**
@@ -116,6 +85,61 @@ void bsp_StartHardTimer(uint8_t _CC, uint32_t _uiTimeOut, void * _pCallBack)
     }
 }
 
+/**
+ * @brief                   按固定周期重新启动硬件定时器
+ *                          在该通道的回调函数中调用，从上一次到期时刻(而不是当前时刻)起再定时，
+ *                          周期不受中断响应和回调执行时间的影响。回调函数不变
+ * 
+ * @param _CC               定时器通道  1~4
+ * @param _uiPeriod         定时周期, 单位 1us, 最大 32767
+ */
+void bsp_RestartHardTimer(uint8_t _CC, uint32_t _uiPeriod)
+{
+    uint16_t cnt_tar;
+    uint16_t it;
+    __IO uint32_t* ccr;
+	TIM_TypeDef* TIMx = TIM3;
+
+    if (_CC < 1 || _CC > 4)
+    {
+        return;
+    }
+    ccr = &TIMx->CCR1 + (_CC - 1);          /* CCR1~CCR4 地址连续 */
+    it = (uint16_t)(TIM_IT_CC1 << (_CC - 1));
+
+    cnt_tar = (uint16_t)(*ccr + _uiPeriod);
+    /* 回调执行过久已错过下一次到期时刻，从当前时刻起定时，避免等待计数器回绕一圈 */
+    if ((int16_t)(cnt_tar - (uint16_t)TIMx->CNT) <= 0)
+    {
+        cnt_tar = (uint16_t)(TIMx->CNT + _uiPeriod);
+    }
+
+    *ccr = cnt_tar;
+    TIMx->SR = (uint16_t)~it;               /* 清除中断标志 */
+    TIMx->DIER |= it;                       /* 使能中断 */
+}
+
+/**
+ * @brief                   停止硬件定时器
+ *                          尚未到期的定时不再执行回调函数
+ * 
+ * @param _CC               定时器通道  1~4
+ */
+void bsp_StopHardTimer(uint8_t _CC)
+{
+    uint16_t it;
+	TIM_TypeDef* TIMx = TIM3;
+
+    if (_CC < 1 || _CC > 4)
+    {
+        return;
+    }
+    it = (uint16_t)(TIM_IT_CC1 << (_CC - 1));
+
+    TIMx->DIER &= (uint16_t)~it;            /* 禁能中断 */
+    TIMx->SR = (uint16_t)~it;               /* 清除中断标志 */
+}
+
 /**
  * @brief                       TIM3中断处理函数
  * 
@@ -124,6 +148,13 @@ void TIM3_IRQHandler(void)
 {
 	uint16_t itstatus = 0x0, itenable = 0x0;
 	TIM_TypeDef* TIMx = TIM3;
+
+	/* 计数器溢出，扩展时间基准高位 */
+	if ((TIMx->SR & TIM_IT_UPDATE) && (TIMx->DIER & TIM_IT_UPDATE))
+	{
+		TIMx->SR = (uint16_t)~TIM_IT_UPDATE;
+		bsp_TimebaseOverflow();
+	}
     
   	itstatus = TIMx->SR & TIM_IT_CC1;
 	itenable = TIMx->DIER & TIM_IT_CC1;
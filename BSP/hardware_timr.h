@@ -1,8 +1,11 @@
 #ifndef __HARDWARE_TIMR_H
 #define __HARDWARE_TIMR_H
 #include "main.h"
+#include "bsp_timebase.h"
 
 void bsp_InitHardTimer(void);
 void bsp_StartHardTimer(uint8_t _CC, uint32_t _uiTimeOut, void * _pCallBack);
+void bsp_RestartHardTimer(uint8_t _CC, uint32_t _uiPeriod);
+void bsp_StopHardTimer(uint8_t _CC);
 
 #endif  // __HARDWARE_TIMR_H
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include "hardware_timr.h"
 #include "string.h"
 #include "bsp_usart.h"
+#include "bsp_motor.h"
 
 /*
 *********************************************************************************************************
@@ -780,6 +781,7 @@ err_ret:
 *********************************************************************************************************
 *	函 数 名: MODS_04H
 *	功能说明: 读取输入寄存器（对应A01/A02） SMA
+*	          地址REG_TRACE_START起为步进时序跟踪缓冲区，一次最多读取REG_TRACE_READ_MAX个
 *	形    参: 无
 *	返 回 值: 无
 *********************************************************************************************************
@@ -818,8 +820,8 @@ static void MODS_04H(void)
 	uint16_t reg;
 	uint16_t num;
 	uint16_t i;
-	uint16_t status[A_REG_SIZE];
-	memset(status, 0, A_REG_SIZE); 
+	uint16_t status[REG_TRACE_READ_MAX];
+	memset(status, 0, sizeof(status)); 
 
     /** 第1步： 判断接到指定个数数据 ===============================================================*/
 	/* 地址（8bit）+指令（8bit）+寄存器起始地址高低字节（16bit）+寄存器个数（16bit）+ CRC16 */
@@ -836,6 +838,22 @@ static void MODS_04H(void)
 	reg = BEBufToUint16(&g_tModS.RxBuf[2]); /* 寄存器号 */
 	num = BEBufToUint16(&g_tModS.RxBuf[4]);	/* 寄存器个数 */
 	
+	/* 步进时序跟踪缓冲区: 批量读取，超出已记录间隔数的部分为0 */
+	if (reg >= REG_TRACE_START)
+	{
+		if (num == 0 || num > REG_TRACE_READ_MAX || (reg + num - 1) > REG_TRACE_END)
+		{
+			g_tModS.RspCode = RSP_ERR_REG_ADDR;		/* 寄存器地址错误 */
+			goto err_ret;
+		}
+
+		for (i = 0; i < num; i++)
+		{
+			status[i] = Stepper_TraceRead(reg + i - REG_TRACE_START);
+		}
+		goto err_ret;
+	}
+
 	/* 验证寄存器地址范围 */
 	if ((reg < REG_A_START) || (reg + num - 1) > REG_A_END)
 	{
@@ -2,6 +2,7 @@
 #define __MODBUY_SLAVE_H
 #include "main.h"
 #include "msg_fifo.h"
+#include "bsp_motor.h"    /* STEPPER_TRACE_SIZE */
 
 
 /*
@@ -27,7 +28,7 @@
 /* 03H 读保持寄存器 */
 /* 06H 写保持寄存器 */
 /* 10H 写多个保存寄存器 */
-#define P_REG_SIZE    32   /* 定义保持寄存器数组大小 */
+#define P_REG_SIZE    48   /* 定义保持寄存器数组大小 */
 #define REG_P_START    0x00 /* 保持寄存器起始地址 */
 #define REG_P_END     (REG_P_START + P_REG_SIZE - 1) /* 保持寄存器结束地址 */
 
@@ -36,6 +37,11 @@
 #define REG_A_START    0x00 /* 模拟量寄存器起始地址 */
 #define REG_A_END     (REG_A_START + A_REG_SIZE - 1) /* 模拟量寄存器结束地址 */
 
+/* 04H 读取步进时序跟踪缓冲区(上升沿间隔us，最早的在前) */
+#define REG_TRACE_START    0x100 /* 跟踪缓冲区起始地址 */
+#define REG_TRACE_END     (REG_TRACE_START + STEPPER_TRACE_SIZE - 1) /* 跟踪缓冲区结束地址 */
+#define REG_TRACE_READ_MAX ((S_TX_BUF_SIZE - 5) / 2) /* 一次最多读取的间隔数(受发送缓冲区限制) */
+
 
 /* RTU 应答代码 */
 #define RSP_OK				0		/* 成功 */
@@ -66,7 +72,7 @@ typedef struct
 
 typedef struct
 {	/* 03H 06H 读写保持寄存器 */
-	uint16_t P[P_REG_SIZE];    /* 支持最多32个保持寄存器 */
+	uint16_t P[P_REG_SIZE];    /* 支持最多48个保持寄存器 */
 
 	/* 04H 读取模拟量寄存器 */
 	int16_t A[A_REG_SIZE];    /* 支持最多32个模拟量寄存器 */
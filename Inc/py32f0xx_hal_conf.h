@@ -62,7 +62,7 @@
 /* #define HAL_SPI_MODULE_ENABLED */  
 /* #define HAL_RTC_MODULE_ENABLED */   
 /* #define HAL_LED_MODULE_ENABLED */ 
-/* #define HAL_EXTI_MODULE_ENABLED */
+#define HAL_EXTI_MODULE_ENABLED
 #define HAL_CORTEX_MODULE_ENABLED
   
 /* ########################## Oscillator Values adaptation ####################*/
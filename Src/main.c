@@ -37,9 +37,17 @@
 #include "74HC595.h" /* 添加74HC595头文件 */
 #include "74HC165.h" /* 添加74HC165头文件 */
 #include "bsp_motor.h"
+#include "bsp_planner.h"
+#include "bsp_step_dma.h"
+#include "bsp_limit.h"
+#include "bsp_home.h"
+#include "bsp_step_pwm.h"
 // #include "msg_fifo.h"
 
 /* Private define ------------------------------------------------------------*/
+// STEP脉冲改由DMA写BSRR输出的电机(bit0~3对应电机1~4)，只给需要最高步进速率的电机使用:
+// DMA边沿对齐到2us节拍并提前生成，填充中断一直运行。为0时不启动TIM16/DMA，全部由比较中断输出
+#define MOTOR_STEP_DMA_MASK   0x00
 /* Private variables ---------------------------------------------------------*/
 /* Private user code ---------------------------------------------------------*/
 /* Private macro -------------------------------------------------------------*/
@@ -54,6 +62,11 @@ StepperMotor_t g_tMotor1; // 步进电机结构体实例
 StepperMotor_t g_tMotor2; // 步进电机结构体实例
 StepperMotor_t g_tMotor3; // 步进电机结构体实例
 StepperMotor_t g_tMotor4; // 步进电机结构体实例
+static StepperMotor_t* const s_tMotors[4] = {&g_tMotor1, &g_tMotor2, &g_tMotor3, &g_tMotor4};
+static uint16_t s_u16TraceSel = 0;  // 最近一次执行的byte5(步进时序跟踪的电机)
+
+Planner_t g_tPlanner1;    // 电机1运动段队列
+Homing_t g_tHoming[4];    // 各电机回原点过程
 
 /**
  * @brief         设置系统时钟为48Mhz，必须在HAL_Init之后调用
@@ -116,42 +129,143 @@ void IO_Status_Read_Task(void *param)
   }
 }
 
-// 当前IO的状态 
-uint32_t g_u32IOStatus = 0; // 当前IO状态
-
 void IO_Status_Write_Task(void *param)
 {
-  // 1. 读取 g_tVar.D数组中线圈的状态，按照位放在 g_u32IOStatus中
+  uint32_t coils = 0;
 
-  // 遍历D数组（线圈状态），组合成一个32位整数
-  for (int i = 0; i < D_COIL_SIZE && i < 16; i++) // 只处理前24位，因为74HC595接收24位
+  // 1. 读取 g_tVar.D数组中线圈的状态，按照位组合成输出位(低16位)
+  for (int i = 0; i < D_COIL_SIZE && i < 16; i++)
   {
     if (g_tVar.D[i]) // 如果线圈状态为1
     {
-      g_u32IOStatus |= (1UL << i); // 将对应位置1
-    }else{
-      g_u32IOStatus &= ~(1UL << i); // 将对应位置0
+      coils |= (1UL << i); // 将对应位置1
     }
   }
 
-  // 2. 将 g_u32IOStatus 中的状态写入到74HC595中
-  HC595_Send24Bits(g_u32IOStatus); // 发送24位数据到74HC595
+  // 2. 只修改74HC595输出映像，有变化时由主循环统一输出(高8位为电机DIR/EN)
+  HC595_WriteBits(0xFFFF, coils);
+}
 
+/**
+  * @brief  电机位置计数中累计的反向间隙补偿步数(byte15、byte16不含补偿)
+  * @param  motor 步进电机结构体指针
+  * @retval 补偿步数
+  */
+static uint32_t Motor_BacklashSteps(StepperMotor_t *motor)
+{
+  return motor->position - Stepper_GetPosition(motor);
 }
 
 void Motor_Control_Task(void *param)
 {
+  static uint8_t s_u8JogMode = 0;     // 速度模式
+  static uint16_t s_u16JogSpeed = 0;  // 速度模式下最近一次执行的byte18
+  static uint16_t s_u16UnitCfg[3];    // 最近一次生效的byte32-34
+
+  // 步进时序跟踪: byte5写入1~4打开四个电机的统计并记录该电机的步进间隔，写入0停止(保留结果供读取)
+  if (g_tVar.P[5] != s_u16TraceSel && g_tVar.P[5] <= 4)
+  {
+    s_u16TraceSel = g_tVar.P[5];
+    for (int i = 0; i < 4; i++)
+    {
+      Stepper_EnableTrace(s_tMotors[i], s_u16TraceSel != 0);
+    }
+    Stepper_TraceCapture(s_u16TraceSel ? s_tMotors[s_u16TraceSel - 1] : NULL);
+  }
+
+  // 回原点: 四个电机同时执行，写入停止命令中断。位置重新计数后，队列终点在下一次命令6排队时同步
+  if (g_tVar.P[10] == 8)
+  {
+    HomingConfig_t config = {g_tVar.P[0], g_tVar.P[1], g_tVar.P[14], g_tVar.P[2], g_tVar.P[3], 0};
+    Planner_Clear(&g_tPlanner1);
+    for (int i = 0; i < 4; i++)
+    {
+      Homing_Start(&g_tHoming[i], &config);
+    }
+    g_tVar.P[10] = 0; // 清除命令
+  }
+  else if (g_tVar.P[10] == 4 || g_tVar.P[10] == 5)
+  {
+    for (int i = 0; i < 4; i++)
+    {
+      Homing_Abort(&g_tHoming[i], g_tVar.P[10] == 4);
+    }
+  }
+
+  // 速度模式: 写入7进入，之后修改byte18即按加速度变速(可过零反向)，写入其他命令退出
+  if (g_tVar.P[10] == 7 && !g_tPlanner1.running)
+  {
+    if (g_tMotor1.state == STEPPER_STATE_IDLE)
+    {
+      Stepper_SetSpeed(&g_tMotor1, g_tVar.P[12], g_tVar.P[13], g_tVar.P[14]); // 设置电机速度
+    }
+    s_u8JogMode = 1;
+    s_u16JogSpeed = g_tVar.P[18];
+    Stepper_Jog(&g_tMotor1, (int16_t)g_tVar.P[18]);
+    g_tVar.P[10] = 0; // 清除命令
+  }
+  else if (g_tVar.P[10] != 0)
+  {
+    s_u8JogMode = 0;
+  }
+  else if (s_u8JogMode && g_tVar.P[18] != s_u16JogSpeed)
+  {
+    s_u16JogSpeed = g_tVar.P[18];
+    Stepper_Jog(&g_tMotor1, (int16_t)g_tVar.P[18]);
+  }
+
+  // 工程单位参数只在变化时重新计算换算比例，方向取反运行中设置不成功，停止后重试
+  if (g_tVar.P[32] != 0 &&
+      (g_tVar.P[32] != s_u16UnitCfg[0] || g_tVar.P[33] != s_u16UnitCfg[1] || g_tVar.P[34] != s_u16UnitCfg[2]))
+  {
+    uint32_t steps_per_unit = ((uint32_t)g_tVar.P[32] * 65536 + 5000) / 10000; // 整步/mm*100 -> 整步/0.01mm(Q16.16)
+    if (Stepper_SetUnits(&g_tMotor1, steps_per_unit, g_tVar.P[33] ? g_tVar.P[33] : 1, g_tVar.P[34] != 0))
+    {
+      s_u16UnitCfg[0] = g_tVar.P[32];
+      s_u16UnitCfg[1] = g_tVar.P[33];
+      s_u16UnitCfg[2] = g_tVar.P[34];
+    }
+  }
+
+  // 反向间隙: 只对运动段队列(命令6)的反向运动补偿
+  if (g_tMotor1.backlash != g_tVar.P[28])
+  {
+    Stepper_SetBacklash(&g_tMotor1, g_tVar.P[28]);
+  }
+
+  // 运动段排队，运行中也可以继续添加，队列满时保留命令等待下次处理
+  if (g_tVar.P[10] == 6)
+  {
+    uint32_t target = g_tVar.P[16];
+    if (Planner_Enqueue(&g_tPlanner1, &target, g_tVar.P[12]))
+    {
+      g_tVar.P[10] = 0; // 清除命令
+    }
+  }
+
   if (g_tMotor1.state == STEPPER_STATE_IDLE)
   {
 
     /*
         // 读取g_tVar.P[]
 byte10          默认状态                0         
-                电机移动到目标位置       1
+                电机移动到目标位置       1    （运行中写入时从当前速度重新规划到新的byte16/byte12）
                 电机移动相对位置         2
                 电机匀速运动             3    （会按照 byte18）
                 电机急停                4
                 电机停止（减速停止）      5
+                运动段排队              6    （目标为byte16，速度为byte12，不等待停止）
+                速度模式                7    （按byte14加速度变速到byte18，之后修改byte18即变速，其他命令退出）
+                回原点                  8    （四个电机同时: 快速寻找 -> 退离 -> 慢速锁存 -> 偏移，写入4/5中断）
+                按mm移动到目标位置       9    （目标为byte38-39，速度参数为byte35-37）
+                按mm移动相对位置         10   （距离为byte38-39，正值为正转）
+
+                byte0           回原点寻找速度              步/秒
+                byte1           回原点锁存速度              步/秒
+                byte2           回原点退离步数
+                byte3           回原点偏移步数              锁存点正转方向，移动后位置为0
+                byte4           回原点状态                  只读 bit0-3进行中 bit4-7完成 bit8-11失败(电机1-4)
+                byte5           步进时序跟踪                1~4 统计四个电机并记录该电机的步进间隔  0 停止
 
 
                 byte11          电机速度寄存器              只能为正值
@@ -161,16 +275,52 @@ byte10          默认状态                0
                 byte15          电机当前位置                只读
                 byte16          电机移动到目标位置（绝对位置）           只能为正值
                 byte17          电机移动到相对位置           正值为正转，负值为反转。绝对位置不能突破到0以下。
-                byte18          电机匀速运动寄存器           正值为正转，负值为反转。
+                byte18          电机匀速运动寄存器           正值为正转，负值为反转。速度模式下为目标速度
                 byte19          是否启动限位开关             1 启动限位开关  0不启用限位
                 byte20          正转限位开关编号            
                 byte21          反转限位开关编号
                 byte22          电机当前运行状态
+                byte23          电机加减速曲线              0 梯形(查表)  1 恒加速度  2 S曲线
+                byte24          S曲线加加速度寄存器         单位100步/秒^3，0表示不限制
+                byte25          运动段队列剩余空间          只读
+                byte26          步段流水线欠载次数          只读
+                byte27          步段流水线最小深度          只读
+                byte28          反向间隙                    步，运动段队列中反向时先补偿，补偿步数不计入byte15
+
+                byte30          波特率
+                byte31          Modbus ID
+                byte32          每mm整步数                  单位0.01步，例如导程8mm、200步/转为2500，0表示不使用mm单位
+                byte33          细分数                      1~256，0按1处理
+                byte34          方向取反                    1 DIR引脚电平取反(停止时生效)
+                byte35          最大速度                    单位0.1mm/秒
+                byte36          启动速度                    单位0.1mm/秒
+                byte37          加速度                      单位mm/秒^2
+                byte38-39       目标位置/相对距离           单位0.01mm，32位有符号数，byte38为高16位
+                byte40-41       电机当前位置                只读，单位0.01mm，32位有符号数，byte40为高16位
+
+        // 读取g_tVar.A[](04H)
+                A0-A15          电机1-4步进时序统计         每个电机4个: 最小误差、最大误差、平均误差(us)、统计间隔数低16位
+                A16             跟踪缓冲区间隔数
+                A17             正在记录间隔的电机          0 未记录
+                0x100起         跟踪缓冲区                  上升沿间隔(us)，最早的在前，一次最多读取61个
     */
+    if ((g_tVar.P[10] >= 1 && g_tVar.P[10] <= 3) || g_tVar.P[10] == 9 || g_tVar.P[10] == 10)
+    {
+      // 曲线参数只在变化时重新生成延时表
+      if (g_tMotor1.jerk != (uint32_t)g_tVar.P[24] * 100)
+      {
+        Stepper_SetJerk(&g_tMotor1, (uint32_t)g_tVar.P[24] * 100);
+      }
+      if (g_tMotor1.profile != g_tVar.P[23] && g_tVar.P[23] <= STEPPER_PROFILE_SCURVE)
+      {
+        Stepper_SetProfile(&g_tMotor1, (StepperProfile_t)g_tVar.P[23]);
+      }
+    }
+    
     if (g_tVar.P[10] == 1)
     {
       Stepper_SetSpeed(&g_tMotor1,g_tVar.P[12], g_tVar.P[13], g_tVar.P[14]); // 设置电机速度
-      Stepper_MoveTo(&g_tMotor1, g_tVar.P[16]); // 移动到目标位置
+      Stepper_MoveTo(&g_tMotor1, g_tVar.P[16] + Motor_BacklashSteps(&g_tMotor1)); // 移动到目标位置
     }else if (g_tVar.P[10] == 2)
     {
       Stepper_SetSpeed(&g_tMotor1, g_tVar.P[12], g_tVar.P[13], g_tVar.P[14]); // 设置电机速度
@@ -184,6 +334,19 @@ byte10          默认状态                0
     }else if (g_tVar.P[10] == 3)
     {
       Stepper_RunSpeed(&g_tMotor1, g_tVar.P[18]); // 匀速运动
+    }else if ((g_tVar.P[10] == 9 || g_tVar.P[10] == 10) && g_tVar.P[32] != 0)
+    {
+      // 单位为0.01mm: 速度0.1mm/秒为10单位/秒，加速度mm/秒^2为100单位/秒^2
+      int32_t units = (int32_t)(((uint32_t)g_tVar.P[38] << 16) | g_tVar.P[39]);
+      Stepper_SetSpeedUnits(&g_tMotor1, (uint32_t)g_tVar.P[35] * 10, (uint32_t)g_tVar.P[36] * 10,
+                            (uint32_t)g_tVar.P[37] * 100);
+      if (g_tVar.P[10] == 9)
+      {
+        Stepper_MoveToUnits(&g_tMotor1, units); // 移动到目标位置(mm)
+      }else
+      {
+        Stepper_MoveUnits(&g_tMotor1, units); // 移动相对位置(mm)
+      }
     }
     g_tVar.P[10] = 0; // 清除命令
   }else{
@@ -192,19 +355,71 @@ byte10          默认状态                0
     {
       Stepper_Stop(&g_tMotor1, 1); // 立即停止
       g_tVar.P[10] = 0; // 清除命令
-    }else if (g_tVar.P[10] == 0)
+    }else if (g_tVar.P[10] == 5)
     {
       Stepper_Stop(&g_tMotor1, 0); // 减速停止
       g_tVar.P[10] = 0; // 清除命令
+    }else if (g_tVar.P[10] == 1 && !g_tPlanner1.running)
+    {
+      // 运行中修改目标位置/最大速度，从当前速度重新规划，不停止
+      if (g_tVar.P[12] != 0 && g_tVar.P[12] != g_tMotor1.max_speed)
+      {
+        Stepper_UpdateMaxSpeed(&g_tMotor1, g_tVar.P[12]);
+      }
+      Stepper_UpdateTarget(&g_tMotor1, g_tVar.P[16] + Motor_BacklashSteps(&g_tMotor1));
+      g_tVar.P[10] = 0; // 清除命令
     }
 
   }
   g_tVar.P[22] = g_tMotor1.state; // 更新电机状态
-  g_tVar.P[15] = g_tMotor1.position; // 更新电机当前位置
+  g_tVar.P[25] = Planner_GetFree(&g_tPlanner1); // 更新队列剩余空间
+
+  StepperPipelineStats_t stats;
+  Stepper_GetPipelineStats(&g_tMotor1, &stats);
+  g_tVar.P[26] = (uint16_t)stats.underrun;  // 步段欠载次数
+  g_tVar.P[27] = stats.depth_min;           // 步段队列最小深度
+}
+
+/**
+  * @brief  刷新只读状态寄存器，在处理Modbus请求前调用，主站读到的是应答时的状态
+  * @retval None
+  */
+static void Motor_Status_Update(void)
+{
+  uint16_t homing = 0;
+  for (int i = 0; i < 4; i++)
+  {
+    if (Homing_IsBusy(&g_tHoming[i]))
+      homing |= 1U << i;
+    else if (g_tHoming[i].state == HOMING_DONE)
+      homing |= 1U << (4 + i);
+    else if (g_tHoming[i].state == HOMING_ERROR)
+      homing |= 1U << (8 + i);
+  }
+  g_tVar.P[4] = homing; // 回原点状态
+
+  g_tVar.P[15] = Stepper_GetPosition(&g_tMotor1); // 更新电机当前位置(不含反向间隙补偿步数)
+  int32_t position_units = Stepper_GetPositionUnits(&g_tMotor1);
+  g_tVar.P[40] = (uint16_t)((uint32_t)position_units >> 16); // 当前位置(0.01mm)
+  g_tVar.P[41] = (uint16_t)position_units;
+
+  // 步进时序统计
+  StepperTraceStats_t trace;
+  for (int i = 0; i < 4; i++)
+  {
+    Stepper_GetTraceStats(s_tMotors[i], &trace);
+    g_tVar.A[i * 4 + 0] = trace.err_min;
+    g_tVar.A[i * 4 + 1] = trace.err_max;
+    g_tVar.A[i * 4 + 2] = trace.err_mean;
+    g_tVar.A[i * 4 + 3] = (int16_t)trace.count;
+  }
+  g_tVar.A[16] = Stepper_TraceCount();
+  g_tVar.A[17] = s_u16TraceSel;
 }
 
 void ModbusPoll_Task(void *param)
 {
+  Motor_Status_Update();
   MODS_Poll();
 }
 
@@ -231,120 +446,37 @@ void SystemSoftTime_init(void)
   SoftTimer_Create(100, 0, IO_Status_Read_Task, NULL);      // IO状态读取定时器
   SoftTimer_Create(100, 0, IO_Status_Write_Task, NULL);     // IO状态写入定时器
   SoftTimer_Create(10, 0, ModbusPoll_Task, NULL);           // Modbus从站轮询定时器
-  // SoftTimer_Create(100, 0, Motor_Control_Task, NULL);        // 电机控制定时器
+  SoftTimer_Create(10, 0, Motor_Control_Task, NULL);        // 电机控制定时器(速度模式修改byte18后及时变速)
 }
 
-void Motor1PinControl(StepperPinType_t pinType, uint8_t state)
-{
-  switch (pinType)
-  {
-    case PIN_TYPE_PWM:
-      HAL_GPIO_WritePin(GPIOA, GPIO_PIN_4, state ? GPIO_PIN_SET : GPIO_PIN_RESET); // PA4
-      break;
-    case PIN_TYPE_DIR:
-      // HC959 BIT 16  DIR 
-      if (state)
-        g_u32IOStatus |= (1UL << 17);  // 设置第16位为1
-      else
-        g_u32IOStatus &= ~(1UL << 17); // 设置第16位为0
-        HC595_Send24Bits(g_u32IOStatus); // 更新74HC595的状态
-      break;
-    case PIN_TYPE_EN:
-      // HC959 BIT 17  EN
-      if (state)
-        g_u32IOStatus |= (1UL << 16);  // 设置第17位为1
-      else
-        g_u32IOStatus &= ~(1UL << 16); // 设置第17位为0
-        HC595_Send24Bits(g_u32IOStatus); // 更新74HC595的状态
-      break;
-    default:
-      break;
-  }
-
-}
+// 电机引脚描述: STEP为GPIO，DIR/EN为74HC595输出位
+static const StepperPinDesc_t s_tMotorPins[4] = {
+  {GPIOA, GPIO_PIN_4, 17, 16}, // M1 PA4
+  {GPIOB, GPIO_PIN_3, 19, 18}, // M2 PB3
+  {GPIOA, GPIO_PIN_0, 21, 20}, // M3 PA0
+  {GPIOA, GPIO_PIN_1, 23, 22}, // M4 PA1
+};
+
+// 限位开关: 常开接地，EXTI上下沿中断，反转限位同时作为原点
+static const LimitInput_t s_tLimitInputs[5] = {
+  {GPIOA, GPIO_PIN_6, 0, &g_tMotor1, STEPPER_DIR_CCW},  // M1 原点/反转限位 PA6
+  {GPIOA, GPIO_PIN_8, 0, &g_tMotor1, STEPPER_DIR_CW},   // M1 正转限位 PA8
+  {GPIOA, GPIO_PIN_11, 0, &g_tMotor2, STEPPER_DIR_CCW}, // M2 原点 PA11
+  {GPIOA, GPIO_PIN_12, 0, &g_tMotor3, STEPPER_DIR_CCW}, // M3 原点 PA12
+  {GPIOA, GPIO_PIN_15, 0, &g_tMotor4, STEPPER_DIR_CCW}, // M4 原点 PA15
+};
 
-void Motor2PinControl(StepperPinType_t pinType, uint8_t state)
-{
-  switch (pinType)
-  {
-    case PIN_TYPE_PWM:
-      HAL_GPIO_WritePin(GPIOB, GPIO_PIN_3, state ? GPIO_PIN_SET : GPIO_PIN_RESET); // PB3
-      break;
-    case PIN_TYPE_DIR:
-      // HC959 BIT 16  DIR 
-      if (state)
-        g_u32IOStatus |= (1UL << 19);  // 设置第16位为1
-      else
-        g_u32IOStatus &= ~(1UL << 19); // 设置第16位为0
-        HC595_Send24Bits(g_u32IOStatus); // 更新74HC595的状态
-      break;
-    case PIN_TYPE_EN:
-      // HC959 BIT 17  EN
-      if (state)
-        g_u32IOStatus |= (1UL << 18);  // 设置第17位为1
-      else
-        g_u32IOStatus &= ~(1UL << 18); // 设置第17位为0
-        HC595_Send24Bits(g_u32IOStatus); // 更新74HC595的状态
-      break;
-    default:
-      break;
-  }
-}
-
-void Motor3PinControl(StepperPinType_t pinType, uint8_t state)
-{
-  switch (pinType)
-  {
-    case PIN_TYPE_PWM:
-      HAL_GPIO_WritePin(GPIOA, GPIO_PIN_0, state ? GPIO_PIN_SET : GPIO_PIN_RESET); // PA0
-      break;
-    case PIN_TYPE_DIR:
-      // HC959 BIT 16  DIR 
-      if (state)
-        g_u32IOStatus |= (1UL << 21);  
-      else
-        g_u32IOStatus &= ~(1UL << 21); 
-        HC595_Send24Bits(g_u32IOStatus); // 更新74HC595的状态
-      break;
-    case PIN_TYPE_EN:
-      // HC959 BIT 17  EN
-      if (state)
-        g_u32IOStatus |= (1UL << 20);  
-      else
-        g_u32IOStatus &= ~(1UL << 20); 
-        HC595_Send24Bits(g_u32IOStatus); // 更新74HC595的状态
-      break;
-    default:
-      break;
-  }
-}
-
-void Motor4PinControl(StepperPinType_t pinType, uint8_t state)
+/**
+  * @brief  修改74HC595输出映像的一个位(电机DIR/EN)，由主循环统一输出
+  * @param  bit 输出位序号
+  * @param  state 输出电平
+  * @retval 本次修改的映像序号
+  */
+uint32_t Motor_ExpanderWrite(uint8_t bit, uint8_t state)
 {
-  switch (pinType)
-  {
-    case PIN_TYPE_PWM:
-      HAL_GPIO_WritePin(GPIOA, GPIO_PIN_1, state ? GPIO_PIN_SET : GPIO_PIN_RESET); // PA1
-      break;
-    case PIN_TYPE_DIR:
-      // HC959 BIT 16  DIR 
-      if (state)
-        g_u32IOStatus |= (1UL << 23);  
-      else
-        g_u32IOStatus &= ~(1UL << 23); 
-        HC595_Send24Bits(g_u32IOStatus); // 更新74HC595的状态
-      break;
-    case PIN_TYPE_EN:
-      // HC959 BIT 17  EN
-      if (state)
-        g_u32IOStatus |= (1UL << 22);  
-      else
-        g_u32IOStatus &= ~(1UL << 22); 
-        HC595_Send24Bits(g_u32IOStatus); // 更新74HC595的状态
-      break;
-    default:
-      break;
-  }
+  if (state)
+    return HC595_SetBits(1UL << bit);
+  return HC595_ClearBits(1UL << bit);
 }
 
 void Motor_io_init(void)
@@ -382,7 +514,7 @@ int main(void)
   /* Reset of all peripherals, Initializes the Systick */
   HAL_Init();                                  
   APP_SystemClockConfig(); /* Configure the system clock */
-  HAL_SYSTICK_Config(SystemCoreClock /200000);
+  /* SysTick保持HAL默认的1kHz，微秒时间由bsp_timebase提供 */
   SystemParam_Init(); // 初始化系统参数
 
 
@@ -404,11 +536,49 @@ int main(void)
 
   SystemSoftTime_init(); // 初始化软件定时器
 
-  Stepper_Init(&g_tMotor1, Motor1PinControl); // 初始化步进电机
+  Stepper_TimerInit();  // 初始化步进脉冲引擎定时器(比较中断产生脉冲)
+  Stepper_SetExpander(Motor_ExpanderWrite); // DIR/EN写74HC595
+  Stepper_InitPins(&g_tMotor1, &s_tMotorPins[0]); // 初始化步进电机
+  Stepper_InitPins(&g_tMotor2, &s_tMotorPins[1]);
+  Stepper_InitPins(&g_tMotor3, &s_tMotorPins[2]);
+  Stepper_InitPins(&g_tMotor4, &s_tMotorPins[3]);
+  Stepper_EnablePipeline(&g_tMotor1, 1); // 加减速计算放在主循环，中断只取步段
+  Stepper_EnablePipeline(&g_tMotor2, 1);
+  Stepper_EnablePipeline(&g_tMotor3, 1);
+  Stepper_EnablePipeline(&g_tMotor4, 1);
+  for (int i = 0; i < 4; i++)
+  {
+    if (MOTOR_STEP_DMA_MASK & (1 << i))
+    {
+      Stepper_AttachDma(s_tMotors[i], (s_tMotorPins[i].step_port == GPIOB) ? STEPPER_DMA_PORT_B : STEPPER_DMA_PORT_A,
+                        s_tMotorPins[i].step_pin); // STEP脉冲由DMA写BSRR输出
+    }
+  }
+  if (MOTOR_STEP_DMA_MASK != 0)
+  {
+    bsp_InitStepDma();
+  }
+  bsp_InitStepPwm(&g_tMotor1, GPIOA, GPIO_PIN_4, GPIO_AF4_TIM14); // 电机1的匀速段由TIM14输出
+  Stepper_EnableLimitSwitches(&g_tMotor1, 1); // 限位在中断中停止电机并锁存位置
+  bsp_InitLimit(s_tLimitInputs, 5);
+  Homing_Init(&g_tHoming[0], &g_tMotor1);
+  Homing_Init(&g_tHoming[1], &g_tMotor2);
+  Homing_Init(&g_tHoming[2], &g_tMotor3);
+  Homing_Init(&g_tHoming[3], &g_tMotor4);
+
+  StepperMotor_t* planner1_axes[1] = {&g_tMotor1};
+  Planner_Init(&g_tPlanner1, planner1_axes, 1); // 电机1运动段队列
 
   g_tVar.P[12] = 6000; // 清除保持寄存器
   g_tVar.P[13] = 800; // 清除命令
   g_tVar.P[14] = 500; // 清除命令
+  g_tVar.P[0] = 3000; // 回原点寻找速度
+  g_tVar.P[1] = 200;  // 回原点锁存速度
+  g_tVar.P[2] = 400;  // 回原点退离步数
+  g_tVar.P[33] = 1;    // 细分数
+  g_tVar.P[35] = 300;  // 最大速度30mm/秒
+  g_tVar.P[36] = 40;   // 启动速度4mm/秒
+  g_tVar.P[37] = 100;  // 加速度100mm/秒^2
 
 
   Stepper_SetSpeed(&g_tMotor1, 6000, 800, 500); // 设置电机速度
@@ -419,7 +589,19 @@ int main(void)
   {
       /* 执行软件定时器 */
       SoftTimer_Execute();
-      Stepper_ProcessAllMotors(); 
+      Stepper_ProcessAllMotors(); // 仅处理未分配定时器通道的电机
+      Planner_Poll(&g_tPlanner1);  // 启动队列中的运动段
+      for (int i = 0; i < 4; i++)
+      {
+        Homing_Poll(&g_tHoming[i]); // 回原点各阶段衔接
+      }
+
+      /* 本轮循环中74HC595映像的所有修改只移位输出一次 */
+      uint32_t io_seq;
+      if (HC595_Flush(&io_seq))
+      {
+        Stepper_ExpanderFlushed(io_seq);
+      }
   }
 }
 
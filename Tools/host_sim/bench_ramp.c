@@ -0,0 +1,105 @@
+/**
+ * @file bench_ramp.c
+ * @brief 加减速延时表与原逐步除法算法的对比基准(主机运行)
+ * @note 直接包含 bsp_motor.c 以便调用内部函数。对每组速度参数，以浮点计算的理想
+ *       线性延时为基准，比较原算法和查表算法的每步最大误差、加减速段总时间，
+ *       以及每步延时计算在主机上的耗时(主机有硬件除法，M0+上除法是软件库调用，
+ *       差距会更大)。查表延时超出最小/最大延时或随步数增大的步数计入table_bad_steps
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <math.h>
+#include "host_hal.h"
+
+#define printf(...) ((void)0)
+#include "../../BSP/bsp_motor.c"
+#undef printf
+
+typedef struct {
+    uint32_t max_speed;
+    uint32_t start_speed;
+    uint32_t accel;
+} BenchCase_t;
+
+static const BenchCase_t s_cases[] = {
+    {2000, 500, 2000},
+    {6000, 800, 500},
+    {6000, 800, 20000},
+    {20000, 1000, 50000},
+    {500, 50, 100},
+    {20000, 100, 5000},     // 加减速步数超过16384，向上取整的比例使最后几步越过末段
+};
+
+/* 原实现的加速延时计算(每步一次乘法和一次除法，整数us) */
+static uint32_t ref_accel_delay(const StepperMotor_t* m, uint32_t count)
+{
+    uint32_t max_us = m->max_step_delay >> 8, min_us = m->min_step_delay >> 8;
+    uint32_t d = max_us - ((max_us - min_us) * count) / m->accel_steps;
+    return (d < min_us) ? min_us : d;
+}
+
+static double now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+int main(void)
+{
+    printf("case,max_speed,start_speed,accel,accel_steps,ref_max_err_us,table_max_err_us,table_max_err_pct,"
+           "ramp_time_ideal_us,ramp_time_ref_us,ramp_time_table_us,ref_ns_per_step,table_ns_per_step,table_bad_steps\n");
+
+    for (size_t c = 0; c < sizeof(s_cases) / sizeof(s_cases[0]); c++) {
+        StepperMotor_t m;
+        const BenchCase_t* bc = &s_cases[c];
+
+        memset(&m, 0, sizeof(m));
+        Stepper_Init(&m, NULL);
+        Stepper_SetSpeed(&m, bc->max_speed, bc->start_speed, bc->accel);
+
+        /* 精度：逐步与理想延时比较(加速和减速对称，总时间按两倍计)，查表延时为Q8 */
+        double span = (m.max_step_delay - m.min_step_delay) / 256.0;
+        double ref_err = 0, tab_err = 0, tab_err_pct = 0;
+        double t_ideal = 0, t_ref = 0, t_tab = 0;
+        uint32_t bad = 0, last = m.max_step_delay;
+        for (uint32_t k = 1; k < m.accel_steps; k++) {
+            double ideal = m.max_step_delay / 256.0 - span * k / m.accel_steps;
+            double r = ref_accel_delay(&m, k);
+            uint32_t d = Stepper_RampDelay(&m, k);
+            double t = d / 256.0;
+            if (d < m.min_step_delay || d > last) bad++;
+            last = d;
+            if (fabs(r - ideal) > ref_err) ref_err = fabs(r - ideal);
+            if (fabs(t - ideal) > tab_err) tab_err = fabs(t - ideal);
+            if (100.0 * fabs(t - ideal) / ideal > tab_err_pct) tab_err_pct = 100.0 * fabs(t - ideal) / ideal;
+            t_ideal += ideal;
+            t_ref += r;
+            t_tab += t;
+        }
+        t_ideal *= 2;
+        t_ref *= 2;
+        t_tab *= 2;
+
+        /* 耗时：重复计算整段加速的延时 */
+        volatile uint32_t sink = 0;
+        uint32_t rounds = 20000000 / (m.accel_steps + 1) + 1;
+        double t0 = now_ns();
+        for (uint32_t n = 0; n < rounds; n++)
+            for (uint32_t k = 1; k < m.accel_steps; k++) sink += ref_accel_delay(&m, k);
+        double t1 = now_ns();
+        for (uint32_t n = 0; n < rounds; n++)
+            for (uint32_t k = 1; k < m.accel_steps; k++) sink += Stepper_RampDelay(&m, k);
+        double t2 = now_ns();
+        double steps = (double)rounds * (m.accel_steps - 1);
+        (void)sink;
+
+        printf("%u,%u,%u,%u,%u,%.2f,%.2f,%.3f,%.0f,%.0f,%.0f,%.2f,%.2f,%u\n",
+               (unsigned)c, bc->max_speed, bc->start_speed, bc->accel, m.accel_steps,
+               ref_err, tab_err, tab_err_pct, t_ideal, t_ref, t_tab,
+               (t1 - t0) / steps, (t2 - t1) / steps, bad);
+    }
+    return 0;
+}
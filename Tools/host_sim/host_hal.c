@@ -0,0 +1,58 @@
+/**
+ * @file host_hal.c
+ * @brief 主机仿真用的HAL桩实现和虚拟时间
+ */
+
+#include "host_hal.h"
+
+TIM_TypeDef g_host_tim1;
+TIM_TypeDef g_host_tim3;
+GPIO_TypeDef g_host_gpioa;
+GPIO_TypeDef g_host_gpiob;
+uint32_t SystemCoreClock = 48000000;
+
+/* 虚拟时间(us)，由仿真程序推进 */
+uint64_t g_host_time_us = 0;
+
+HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef *htim)
+{
+    htim->Instance->PSC = htim->Init.Prescaler;
+    htim->Instance->ARR = htim->Init.Period;
+    return HAL_OK;
+}
+
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef *htim)
+{
+    (void)htim;
+    return HAL_OK;
+}
+
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority)
+{
+    (void)IRQn;
+    (void)PreemptPriority;
+    (void)SubPriority;
+}
+
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn)
+{
+    (void)IRQn;
+}
+
+void bsp_InitTimebase(void)
+{
+}
+
+void bsp_TimebaseOverflow(void)
+{
+}
+
+uint32_t bsp_GetTimeUs(void)
+{
+    return (uint32_t)g_host_time_us;
+}
+
+uint64_t bsp_GetTimeUs64(void)
+{
+    return g_host_time_us;
+}
@@ -0,0 +1,15 @@
+/**
+ * @file host_hal.h
+ * @brief 主机仿真用的虚拟时间接口
+ */
+
+#ifndef __HOST_HAL_H
+#define __HOST_HAL_H
+
+#include "py32f0xx_hal.h"
+#include "bsp_timebase.h"
+
+/* 虚拟时间(us)，bsp_GetTimeUs()返回该值 */
+extern uint64_t g_host_time_us;
+
+#endif /* __HOST_HAL_H */
@@ -0,0 +1,183 @@
+/**
+ * @file sim_encoder.c
+ * @brief 编码器闭环仿真(主机运行)
+ * @note 直接包含 bsp_motor.c，电机按轮询方式用虚拟时间(1us步进)驱动。转子模型在STEP上升沿
+ *       按DIR前进一步，但步间隔短于失步间隔(超过转矩能带动的速度)时每隔若干步丢一步，
+ *       堵转的组从指定步数起转子不再转动。编码器按转子位置四倍频计数(每步1.25个计数，
+ *       16位回绕)。输出每组的目标、位置计数、转子位置、补步数、最大跟随误差和故障：
+ *       开环时转子与位置计数的差就是丢掉的步数；闭环时转子应停在目标的补步窗口内，
+ *       堵转时位置计数应等于转子位置。用法: ./sim_encoder，闭环结果不符合时返回1
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "host_hal.h"
+
+#define printf(...) ((void)0)
+#include "../../BSP/bsp_motor.c"
+#undef printf
+
+#define SIM_TIMEOUT_US      20000000ULL
+#define SIM_QUIET_US        (STEPPER_ENC_SETTLE_US * 3)    // 停止后此时间内没有再运动则结束
+#define SIM_COUNTS_NUM      5       // 每步的编码器计数(分子)
+#define SIM_COUNTS_DEN      4       // 每步的编码器计数(分母)
+#define SIM_WINDOW          4       // 补步窗口(步)
+#define SIM_STALL           200     // 堵转阈值(步)
+#define SIM_ORIGIN          30000   // 起点(反转运动不经过0)
+
+typedef struct {
+    const char* name;
+    uint8_t loop;               // 1 闭环
+    uint8_t pipeline;
+    uint8_t reverse;            // 1 编码器计数方向与正转相反
+    StepperDirection_t dir;
+    uint32_t steps;
+    uint32_t slip_interval;     // 步间隔短于此时间(us)时失步，0为不失步
+    uint32_t slip_every;        // 失步时每隔此步数丢一步
+    uint32_t stall_at;          // 转子从起点走过此步数后堵转，0为不堵转
+} SimCase_t;
+
+static const SimCase_t s_cases[] = {
+    {"no_slip",        1, 1, 0, STEPPER_DIR_CW,  20000, 0,   0,  0},
+    {"slip_open",      0, 1, 0, STEPPER_DIR_CW,  20000, 250, 40, 0},
+    {"slip",           1, 1, 0, STEPPER_DIR_CW,  20000, 250, 40, 0},
+    {"slip_no_pipe",   1, 0, 0, STEPPER_DIR_CW,  20000, 250, 40, 0},
+    {"slip_ccw_rev",   1, 1, 1, STEPPER_DIR_CCW, 20000, 250, 40, 0},
+    {"slip_heavy",     1, 1, 0, STEPPER_DIR_CW,  20000, 250, 8,  0},
+    {"stall",          1, 1, 0, STEPPER_DIR_CW,  20000, 0,   0,  6000},
+};
+
+/* 转子模型 */
+static const SimCase_t* s_case;
+static int64_t s_rotor;             // 转子位置(步)
+static uint8_t s_rotor_ccw;         // DIR引脚为高电平(反转)
+static uint64_t s_last_edge;
+static uint32_t s_slip_count;
+static uint32_t s_lost;
+
+/* 引脚回调: STEP上升沿转子前进一步(失步或堵转时不动) */
+static void sim_pin(StepperPinType_t type, uint8_t level)
+{
+    if (type == PIN_TYPE_DIR) {
+        s_rotor_ccw = level;
+        return;
+    }
+    if (type != PIN_TYPE_PWM || !level) {
+        return;
+    }
+
+    uint64_t interval = g_host_time_us - s_last_edge;
+    s_last_edge = g_host_time_us;
+
+    if (s_case->stall_at > 0 && s_rotor - SIM_ORIGIN >= (int64_t)s_case->stall_at) {
+        s_lost++;
+        return;
+    }
+    if (s_case->slip_interval > 0 && interval < s_case->slip_interval &&
+        ++s_slip_count % s_case->slip_every == 0) {
+        s_lost++;
+        return;
+    }
+    s_rotor += s_rotor_ccw ? -1 : 1;
+}
+
+/* 编码器: 四倍频计数器，16位回绕 */
+static uint16_t sim_encoder(StepperMotor_t* motor)
+{
+    int64_t counts = s_rotor * SIM_COUNTS_NUM;
+
+    (void)motor;
+    counts = (counts >= 0) ? counts / SIM_COUNTS_DEN : -((-counts + SIM_COUNTS_DEN - 1) / SIM_COUNTS_DEN);
+    return (uint16_t)(s_case->reverse ? -counts : counts);
+}
+
+/* 结果 */
+typedef struct {
+    uint32_t target;
+    uint32_t final_position;
+    int64_t rotor;
+    uint32_t lost;
+    StepperEncoderStats_t enc;
+    uint64_t time_us;
+} SimResult_t;
+
+static void sim_run(const SimCase_t* c, SimResult_t* res)
+{
+    StepperMotor_t motor;
+    uint64_t idle_since = 0;
+    int32_t scale = (int32_t)(((int64_t)SIM_COUNTS_DEN << 16) / SIM_COUNTS_NUM);
+
+    memset(&motor, 0, sizeof(motor));
+    memset(res, 0, sizeof(*res));
+    g_stepper_list = NULL;
+    g_host_time_us = 0;
+    s_case = c;
+    s_rotor = SIM_ORIGIN;
+    s_rotor_ccw = 0;
+    s_last_edge = 0;
+    s_slip_count = 0;
+    s_lost = 0;
+
+    Stepper_Init(&motor, sim_pin);
+    Stepper_SetSpeed(&motor, 6000, 800, 20000);
+    Stepper_SetProfile(&motor, STEPPER_PROFILE_CONST_ACCEL);
+    Stepper_EnablePipeline(&motor, c->pipeline);
+    motor.position = SIM_ORIGIN;
+    motor.target_position = SIM_ORIGIN;
+    if (c->loop) {
+        Stepper_AttachEncoder(&motor, sim_encoder, c->reverse ? -scale : scale, SIM_WINDOW, SIM_STALL);
+    }
+
+    res->target = (c->dir == STEPPER_DIR_CW) ? SIM_ORIGIN + c->steps : SIM_ORIGIN - c->steps;
+    Stepper_MoveTo(&motor, res->target);
+    while (g_host_time_us < SIM_TIMEOUT_US) {
+        g_host_time_us++;
+        Stepper_ProcessAllMotors();
+        if (motor.state != STEPPER_STATE_IDLE) {
+            idle_since = 0;
+        } else if (idle_since == 0) {
+            idle_since = g_host_time_us;
+        } else if (g_host_time_us - idle_since > SIM_QUIET_US) {
+            break;
+        }
+    }
+
+    res->final_position = motor.position;
+    res->rotor = s_rotor;
+    res->lost = s_lost;
+    res->time_us = idle_since;
+    Stepper_GetEncoderStats(&motor, &res->enc);
+}
+
+int main(void)
+{
+    size_t count = sizeof(s_cases) / sizeof(s_cases[0]);
+    int failed = 0;
+
+    printf("case,name,loop,pipeline,reverse,steps,target,final_position,rotor_position,lost_steps,"
+           "corrected,corrections,error_max,fault,move_time_us,result\n");
+
+    for (size_t i = 0; i < count; i++) {
+        const SimCase_t* c = &s_cases[i];
+        SimResult_t r;
+        const char* result = "-";
+
+        sim_run(c, &r);
+
+        /* 闭环: 转子停在目标的补步窗口内；堵转: 停止并且位置计数等于转子位置 */
+        if (c->loop) {
+            int64_t miss = r.rotor - (int64_t)r.target;
+            int ok = (c->stall_at > 0) ?
+                     (r.enc.fault == STEPPER_ENC_STALL && (int64_t)r.final_position == r.rotor) :
+                     (r.enc.fault == STEPPER_ENC_OK && miss >= -SIM_WINDOW && miss <= SIM_WINDOW);
+            result = ok ? "pass" : "FAIL";
+            failed |= !ok;
+        }
+
+        printf("%u,%s,%u,%u,%u,%u,%u,%u,%lld,%u,%u,%u,%d,%u,%llu,%s\n",
+               (unsigned)i, c->name, c->loop, c->pipeline, c->reverse, c->steps, r.target,
+               r.final_position, (long long)r.rotor, r.lost, r.enc.corrected, r.enc.corrections,
+               r.enc.error_max, r.enc.fault, (unsigned long long)r.time_us, result);
+    }
+    return failed;
+}
@@ -0,0 +1,189 @@
+/**
+ * @file sim_planner.c
+ * @brief 运动段队列仿真(主机运行)
+ * @note 直接包含 bsp_motor.c、bsp_planner.c 和 bsp_home.c，电机按轮询方式用虚拟时间(1us步进)
+ *       驱动，转子在STEP上升沿按DIR前进一步，转子位于原点开关位置及以下时反转限位触发。
+ *       每组先执行若干直接运动、队列运动或回原点，再把一段目标加入队列，检查最后停止时的
+ *       对外位置等于目标、转子位置等于位置计数(队列之外的运动之后，队列终点应先同步为
+ *       电机当前位置)。用法: ./sim_planner，有不符合的组时返回1
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include "host_hal.h"
+
+#define printf(...) ((void)0)
+#include "../../BSP/bsp_motor.c"
+#include "../../BSP/bsp_planner.c"
+#include "../../BSP/bsp_home.c"
+#undef printf
+
+#define SIM_TIMEOUT_US      20000000ULL
+#define SIM_ORIGIN          100000  // 起点(反转运动不经过0)
+#define SIM_STEPS_MAX       4       // 每组最多的运动数
+#define SIM_SWITCH          95000   // 原点开关位置(转子位置)
+
+// 运动方式
+typedef enum {
+    SIM_END = 0,
+    SIM_DIRECT,                 // Stepper_MoveTo
+    SIM_QUEUE,                  // Planner_Enqueue
+    SIM_RESET,                  // Stepper_ResetPosition(目标为复位后的对外位置)
+    SIM_HOME                    // 清空队列后回原点(目标为原点偏移)
+} SimOp_t;
+
+typedef struct {
+    SimOp_t op;
+    uint32_t target;            // 对外位置(相对起点，复位后相对0)
+} SimStep_t;
+
+typedef struct {
+    const char* name;
+    uint16_t backlash;          // 反向间隙(步)
+    SimStep_t steps[SIM_STEPS_MAX];
+} SimCase_t;
+
+static const SimCase_t s_cases[] = {
+    {"queue_queue",        0,  {{SIM_QUEUE, 10000},  {SIM_QUEUE, 5000}}},
+    {"direct_queue",       0,  {{SIM_DIRECT, 10000}, {SIM_QUEUE, 5000}}},
+    {"direct_queue_fwd",   0,  {{SIM_DIRECT, 10000}, {SIM_QUEUE, 15000}}},
+    {"queue_direct_queue", 0,  {{SIM_QUEUE, 8000},   {SIM_DIRECT, 2000}, {SIM_QUEUE, 6000}}},
+    {"reset_queue",        0,  {{SIM_DIRECT, 10000}, {SIM_RESET, 0},     {SIM_QUEUE, 3000}}},
+    {"direct_queue_lash",  40, {{SIM_DIRECT, 10000}, {SIM_QUEUE, 5000}}},
+    {"lash_direct_queue",  40, {{SIM_QUEUE, 10000},  {SIM_DIRECT, 4000}, {SIM_QUEUE, 9000}}},
+    {"home_queue",         0,  {{SIM_QUEUE, 10000},  {SIM_HOME, 0},      {SIM_QUEUE, 3000}}},
+    {"home_offset_queue",  0,  {{SIM_DIRECT, 8000},  {SIM_HOME, 1000},   {SIM_QUEUE, 3000}}},
+    {"home_queue_lash",    40, {{SIM_QUEUE, 10000},  {SIM_HOME, 0},      {SIM_QUEUE, 3000}}},
+};
+
+/* 转子模型 */
+static int64_t s_rotor;             // 转子位置(步)
+static uint8_t s_rotor_ccw;         // DIR引脚为高电平(反转)
+
+/* 引脚回调: STEP上升沿转子前进一步 */
+static void sim_pin(StepperPinType_t type, uint8_t level)
+{
+    if (type == PIN_TYPE_DIR) {
+        s_rotor_ccw = level;
+    } else if (type == PIN_TYPE_PWM && level) {
+        s_rotor += s_rotor_ccw ? -1 : 1;
+    }
+}
+
+/* 运行到电机停止、队列为空并且回原点结束 */
+static void sim_wait(StepperMotor_t* motor, Planner_t* planner, Homing_t* homing)
+{
+    uint8_t on_switch = (s_rotor <= SIM_SWITCH);
+
+    do {
+        g_host_time_us++;
+        Stepper_ProcessAllMotors();
+        if ((s_rotor <= SIM_SWITCH) != on_switch) {
+            on_switch = !on_switch;
+            Stepper_LimitEvent(motor, STEPPER_DIR_CCW, on_switch);
+        }
+        Planner_Poll(planner);
+        Homing_Poll(homing);
+    } while ((motor->state != STEPPER_STATE_IDLE || planner->running || planner->tail != planner->head ||
+              Homing_IsBusy(homing)) && g_host_time_us < SIM_TIMEOUT_US);
+}
+
+/* 结果 */
+typedef struct {
+    uint32_t target;
+    uint32_t position;          // 对外位置
+    uint32_t raw;               // 电机位置计数(含补偿步数)
+    int64_t rotor;              // 转子位置(换算到位置计数的坐标)
+    uint8_t homing;             // 回原点结果(HOMING_x)
+} SimResult_t;
+
+static void sim_run(const SimCase_t* c, SimResult_t* res)
+{
+    StepperMotor_t motor;
+    StepperMotor_t* axes[1] = {&motor};
+    Planner_t planner;
+    Homing_t homing;
+    HomingConfig_t home = {3000, 500, 20000, 400, 0, 0};
+    uint32_t base = SIM_ORIGIN;
+    int64_t rotor_base = 0;     // 转子位置 - 位置计数
+
+    memset(&motor, 0, sizeof(motor));
+    memset(&planner, 0, sizeof(planner));
+    memset(res, 0, sizeof(*res));
+    g_stepper_list = NULL;
+    g_host_time_us = 0;
+    s_rotor = SIM_ORIGIN;
+    s_rotor_ccw = 0;
+
+    Stepper_Init(&motor, sim_pin);
+    Stepper_SetSpeed(&motor, 6000, 800, 20000);
+    Stepper_SetProfile(&motor, STEPPER_PROFILE_CONST_ACCEL);
+    Stepper_SetBacklash(&motor, c->backlash);
+    motor.position = SIM_ORIGIN;
+    motor.target_position = SIM_ORIGIN;
+    Planner_Init(&planner, axes, 1);
+    Homing_Init(&homing, &motor);
+
+    for (uint8_t i = 0; i < SIM_STEPS_MAX && c->steps[i].op != SIM_END; i++) {
+        const SimStep_t* s = &c->steps[i];
+        uint32_t target = base + s->target;
+
+        switch (s->op) {
+        case SIM_DIRECT:
+            Stepper_MoveTo(&motor, target);
+            break;
+        case SIM_QUEUE:
+            Planner_Enqueue(&planner, &target, 6000);
+            break;
+        case SIM_RESET:
+            Stepper_ResetPosition(&motor);
+            target = 0;
+            break;
+        case SIM_HOME:
+            Planner_Clear(&planner);
+            home.offset = s->target;
+            Homing_Start(&homing, &home);
+            target = 0;
+            break;
+        default:
+            break;
+        }
+        res->target = target;
+        sim_wait(&motor, &planner, &homing);
+
+        // 位置重新计数后，后续目标相对0
+        if (s->op == SIM_RESET || s->op == SIM_HOME) {
+            base = 0;
+            rotor_base = s_rotor - (int64_t)motor.position;
+        }
+    }
+
+    res->position = Stepper_GetPosition(&motor);
+    res->raw = motor.position;
+    res->rotor = s_rotor - rotor_base;
+    res->homing = homing.state;
+}
+
+int main(void)
+{
+    size_t count = sizeof(s_cases) / sizeof(s_cases[0]);
+    int failed = 0;
+
+    printf("case,name,backlash,target,position,motor_position,rotor_position,result\n");
+
+    for (size_t i = 0; i < count; i++) {
+        const SimCase_t* c = &s_cases[i];
+        SimResult_t r;
+        int ok;
+
+        sim_run(c, &r);
+
+        // 对外位置等于目标，转子与位置计数一致(含补偿步数)
+        ok = (r.position == r.target && r.rotor == (int64_t)r.raw &&
+              r.homing != HOMING_ERROR);
+        failed |= !ok;
+        printf("%u,%s,%u,%u,%u,%u,%lld,%s\n", (unsigned)i, c->name, c->backlash, r.target, r.position,
+               r.raw, (long long)r.rotor, ok ? "pass" : "FAIL");
+    }
+    return failed;
+}
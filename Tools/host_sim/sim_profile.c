@@ -0,0 +1,413 @@
+/**
+ * @file sim_profile.c
+ * @brief 运动曲线仿真和回归基准(主机运行)
+ * @note 直接包含 bsp_motor.c，电机按轮询方式用虚拟时间(1us步进)驱动 Stepper_ProcessAllMotors
+ *       (其中调用 Stepper_Handler 并填充步段流水线)，引脚回调记录每个STEP上升沿的时间。
+ *       与浮点计算的理想曲线(恒加速度梯形或加加速度受限的S曲线)比较，输出运动时间、
+ *       峰值速度、加速段平均加速度误差、逐步间隔误差、匀速段抖动和匀速段平均速度误差。
+ *       用法: ./sim_profile [-j] [-e 序号]
+ *         -j      JSON格式输出(默认CSV)
+ *         -e n    输出第n组的全部边沿(CSV: step,t_us,interval_us,ideal_interval_us)
+ *       保存一次输出作为基线，修改算法后重新运行并比较即可发现回归
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include "host_hal.h"
+
+#define printf(...) ((void)0)
+#include "../../BSP/bsp_motor.c"
+#undef printf
+
+#define SIM_MAX_EDGES       200000
+#define SIM_TIMEOUT_US      60000000ULL
+#define SIM_CRUISE_TOL      0.001       // 理想速度在峰值的此比例内算作匀速段
+#define SIM_PEAK_TOL        0.005       // 速度到达峰值的此比例内算作加速结束
+
+typedef struct {
+    StepperProfile_t profile;
+    uint8_t pipeline;
+    uint32_t max_speed;
+    uint32_t start_speed;
+    uint32_t accel;
+    uint32_t jerk;
+    uint32_t steps;
+} SimCase_t;
+
+static const SimCase_t s_cases[] = {
+    {STEPPER_PROFILE_LINEAR,      0, 2000,  500,  2000,  0,       5000},
+    {STEPPER_PROFILE_LINEAR,      1, 6000,  800,  20000, 0,       20000},
+    {STEPPER_PROFILE_LINEAR,      0, 20000, 1000, 50000, 0,       50000},
+    {STEPPER_PROFILE_LINEAR,      1, 6000,  800,  20000, 0,       300},
+    {STEPPER_PROFILE_CONST_ACCEL, 0, 2000,  500,  2000,  0,       5000},
+    {STEPPER_PROFILE_CONST_ACCEL, 1, 6000,  800,  20000, 0,       20000},
+    {STEPPER_PROFILE_CONST_ACCEL, 0, 20000, 1000, 50000, 0,       50000},
+    {STEPPER_PROFILE_CONST_ACCEL, 1, 20000, 1000, 50000, 0,       50000},
+    {STEPPER_PROFILE_CONST_ACCEL, 1, 6000,  800,  20000, 0,       300},
+    {STEPPER_PROFILE_SCURVE,      0, 2000,  500,  2000,  20000,   5000},
+    {STEPPER_PROFILE_SCURVE,      1, 6000,  800,  20000, 200000,  20000},
+    {STEPPER_PROFILE_SCURVE,      0, 20000, 1000, 50000, 1000000, 50000},
+    {STEPPER_PROFILE_SCURVE,      1, 20000, 1000, 50000, 1000000, 50000},
+    {STEPPER_PROFILE_SCURVE,      1, 6000,  800,  20000, 200000,  300},
+};
+
+static const char* const s_profile_names[] = {"linear", "const_accel", "scurve"};
+
+/* 理想加速段(时间单位s) */
+typedef struct {
+    double vs;
+    double vp;
+    double j;
+    double ap;
+    double tj;
+    double ta;
+    double t;
+} SimRamp_t;
+
+/* 仿真结果 */
+typedef struct {
+    uint32_t steps_out;
+    uint32_t final_position;
+    double move_time_us;
+    double ideal_time_us;
+    double peak_velocity;
+    double ideal_peak_velocity;
+    double accel_meas;
+    double accel_ideal;
+    double interval_err_rms_us;
+    double interval_err_max_us;
+    double cruise_jitter_us;
+    double cruise_std_us;
+    double cruise_velocity;
+    double max_step_jump_us;
+} SimResult_t;
+
+static double s_edges[SIM_MAX_EDGES];
+static double s_ideal[SIM_MAX_EDGES];
+static uint32_t s_edge_count;
+
+/* 引脚回调: 记录STEP上升沿 */
+static void sim_pin(StepperPinType_t type, uint8_t level)
+{
+    if (type == PIN_TYPE_PWM && level && s_edge_count < SIM_MAX_EDGES) {
+        s_edges[s_edge_count++] = (double)g_host_time_us;
+    }
+}
+
+/* 从vs加速到vp: 加加速度为0时为恒加速度 */
+static void ramp_setup(SimRamp_t* r, double vs, double vp, double a, double j)
+{
+    double dv = vp - vs;
+
+    r->vs = vs;
+    r->vp = vp;
+    r->j = j;
+    if (dv <= 0) {
+        r->ap = a;
+        r->tj = r->ta = r->t = 0;
+        return;
+    }
+    if (j <= 0) {
+        r->ap = a;
+        r->tj = 0;
+        r->ta = dv / a;
+    } else if (a * a <= dv * j) {
+        r->ap = a;
+        r->tj = a / j;
+        r->ta = dv / a - r->tj;
+    } else {
+        r->tj = sqrt(dv / j);
+        r->ap = j * r->tj;
+        r->ta = 0;
+    }
+    r->t = 2 * r->tj + r->ta;
+}
+
+static double ramp_velocity(const SimRamp_t* r, double t)
+{
+    if (t <= 0) {
+        return r->vs;
+    }
+    if (t >= r->t) {
+        return r->vp;
+    }
+    if (t < r->tj) {
+        return r->vs + r->j * t * t / 2;
+    }
+    if (t < r->tj + r->ta) {
+        return r->vs + r->ap * r->tj / 2 + r->ap * (t - r->tj);
+    }
+    t = r->t - t;
+    return r->vp - r->j * t * t / 2;
+}
+
+/* 对称加速段的距离: 平均速度为首尾速度的平均 */
+static double ramp_distance(const SimRamp_t* r)
+{
+    return (r->vs + r->vp) / 2 * r->t;
+}
+
+/**
+ * @brief 计算理想曲线上每一步的时间(s_ideal[k]为位置到达k的时间，us)
+ * @return 走完全部步数的时间(us)
+ */
+static double ideal_profile(const SimCase_t* c, SimRamp_t* ramp)
+{
+    double vs = (c->start_speed < c->max_speed) ? c->start_speed : c->max_speed;
+    double j = (c->profile == STEPPER_PROFILE_SCURVE) ? c->jerk : 0;
+    double n = c->steps;
+    double cruise, t, x, v, total;
+    uint32_t k;
+
+    ramp_setup(ramp, vs, c->max_speed, c->accel, j);
+
+    /* 距离不够时二分查找峰值速度 */
+    if (2 * ramp_distance(ramp) > n) {
+        double lo = vs, hi = c->max_speed;
+        for (int i = 0; i < 60; i++) {
+            ramp_setup(ramp, vs, (lo + hi) / 2, c->accel, j);
+            if (2 * ramp_distance(ramp) > n) {
+                hi = (lo + hi) / 2;
+            } else {
+                lo = (lo + hi) / 2;
+            }
+        }
+        ramp_setup(ramp, vs, lo, c->accel, j);
+    }
+
+    cruise = (n - 2 * ramp_distance(ramp)) / ramp->vp;
+    if (cruise < 0) {
+        cruise = 0;
+    }
+    total = 2 * ramp->t + cruise;
+
+    /* 按1us积分位置，线性插值得到每一步的时间 */
+    s_ideal[0] = 0;
+    k = 1;
+    x = 0;
+    v = vs;
+    for (t = 0; k < c->steps && k < SIM_MAX_EDGES; t += 1e-6) {
+        double tn = t + 1e-6;
+        double vn = (tn < ramp->t) ? ramp_velocity(ramp, tn) :
+                    (tn < ramp->t + cruise) ? ramp->vp :
+                    ramp_velocity(ramp, total - tn);
+        double xn = x + (v + vn) / 2 * 1e-6;
+
+        while (k < c->steps && k < SIM_MAX_EDGES && xn >= k) {
+            s_ideal[k] = (t + (k - x) / (xn - x) * 1e-6) * 1e6;
+            k++;
+        }
+        x = xn;
+        v = vn;
+    }
+    return total * 1e6;
+}
+
+/**
+ * @brief 加速段的平均加速度: 从第一步的速度到首次接近峰值速度
+ */
+static double ramp_accel(const double* times, uint32_t n, double* peak)
+{
+    double v0, vp = 0;
+    uint32_t k;
+
+    if (n < 3) {
+        *peak = (n == 2) ? 1e6 / (times[1] - times[0]) : 0;
+        return 0;
+    }
+    for (k = 1; k < n; k++) {
+        double v = 1e6 / (times[k] - times[k - 1]);
+        if (v > vp) {
+            vp = v;
+        }
+    }
+    *peak = vp;
+
+    v0 = 1e6 / (times[1] - times[0]);
+    for (k = 1; k < n; k++) {
+        if (1e6 / (times[k] - times[k - 1]) >= vp * (1 - SIM_PEAK_TOL)) {
+            break;
+        }
+    }
+    return (k > 1) ? (1e6 / (times[k] - times[k - 1]) - v0) / ((times[k] - times[1]) / 1e6) : 0;
+}
+
+/**
+ * @brief 运行一组参数并统计
+ */
+static void sim_run(const SimCase_t* c, SimResult_t* res)
+{
+    StepperMotor_t motor;
+    SimRamp_t ramp;
+    double err_sq = 0, cruise_min = 1e30, cruise_max = 0, cruise_sum = 0, cruise_sq = 0;
+    uint32_t cruise_n = 0, n, k;
+
+    memset(&motor, 0, sizeof(motor));
+    memset(res, 0, sizeof(*res));
+    g_stepper_list = NULL;
+    g_host_time_us = 0;
+    s_edge_count = 0;
+
+    Stepper_Init(&motor, sim_pin);
+    Stepper_SetSpeed(&motor, c->max_speed, c->start_speed, c->accel);
+    Stepper_SetJerk(&motor, c->jerk);
+    Stepper_SetProfile(&motor, c->profile);
+    Stepper_EnablePipeline(&motor, c->pipeline);
+    Stepper_AddMotor(&motor);
+
+    Stepper_Move(&motor, c->steps, STEPPER_DIR_CW);
+    while (motor.state != STEPPER_STATE_IDLE && g_host_time_us < SIM_TIMEOUT_US) {
+        g_host_time_us++;
+        Stepper_ProcessAllMotors();
+    }
+
+    n = s_edge_count;
+    res->steps_out = n;
+    res->final_position = motor.position;
+    res->ideal_time_us = ideal_profile(c, &ramp);
+    res->ideal_peak_velocity = ramp.vp;
+    if (n < 2) {
+        return;
+    }
+
+    /* 边沿时间从第一步起算 */
+    for (k = n; k-- > 0;) {
+        s_edges[k] -= s_edges[0];
+    }
+    res->move_time_us = s_edges[n - 1] + (s_edges[n - 1] - s_edges[n - 2]);
+    res->accel_meas = ramp_accel(s_edges, n, &res->peak_velocity);
+    res->accel_ideal = ramp_accel(s_ideal, (n < c->steps) ? n : c->steps, &res->ideal_peak_velocity);
+
+    for (k = 1; k < n && k < c->steps; k++) {
+        double interval = s_edges[k] - s_edges[k - 1];
+        double ideal = s_ideal[k] - s_ideal[k - 1];
+        double err = fabs(interval - ideal);
+
+        err_sq += err * err;
+        if (err > res->interval_err_max_us) {
+            res->interval_err_max_us = err;
+        }
+        if (k > 1) {
+            double jump = fabs(interval - (s_edges[k - 1] - s_edges[k - 2]));
+            if (jump > res->max_step_jump_us) {
+                res->max_step_jump_us = jump;
+            }
+        }
+
+        /* 匀速段: 理想速度在峰值附近 */
+        if (1e6 / ideal >= ramp.vp * (1 - SIM_CRUISE_TOL)) {
+            if (interval < cruise_min) {
+                cruise_min = interval;
+            }
+            if (interval > cruise_max) {
+                cruise_max = interval;
+            }
+            cruise_sum += interval;
+            cruise_sq += interval * interval;
+            cruise_n++;
+        }
+    }
+    res->interval_err_rms_us = sqrt(err_sq / (k - 1));
+    if (cruise_n > 0) {
+        double mean = cruise_sum / cruise_n;
+        double var = cruise_sq / cruise_n - mean * mean;
+        res->cruise_jitter_us = cruise_max - cruise_min;
+        res->cruise_std_us = (var > 0) ? sqrt(var) : 0;
+        res->cruise_velocity = 1e6 / mean;
+    }
+}
+
+static double pct(double meas, double ideal)
+{
+    return (ideal != 0) ? (meas - ideal) / ideal * 100 : 0;
+}
+
+int main(int argc, char* argv[])
+{
+    size_t count = sizeof(s_cases) / sizeof(s_cases[0]);
+    int json = 0;
+    long dump = -1;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-j") == 0) {
+            json = 1;
+        } else if (strcmp(argv[i], "-e") == 0 && i + 1 < argc) {
+            dump = strtol(argv[++i], NULL, 10);
+        } else {
+            fprintf(stderr, "usage: %s [-j] [-e case]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    /* 单组边沿输出 */
+    if (dump >= 0) {
+        SimResult_t res;
+
+        if ((size_t)dump >= count) {
+            fprintf(stderr, "case %ld out of range (0~%u)\n", dump, (unsigned)count - 1);
+            return 1;
+        }
+        sim_run(&s_cases[dump], &res);
+        printf("step,t_us,interval_us,ideal_interval_us\n");
+        for (uint32_t k = 0; k < res.steps_out && k < s_cases[dump].steps; k++) {
+            printf("%u,%.0f,%.0f,%.2f\n", k, s_edges[k],
+                   k ? s_edges[k] - s_edges[k - 1] : 0, k ? s_ideal[k] - s_ideal[k - 1] : 0);
+        }
+        return 0;
+    }
+
+    if (json) {
+        printf("[\n");
+    } else {
+        printf("case,profile,pipeline,max_speed,start_speed,accel,jerk,steps,steps_out,final_position,"
+               "move_time_us,ideal_time_us,time_err_pct,peak_velocity,ideal_peak_velocity,"
+               "accel_meas,accel_ideal,accel_err_pct,interval_err_rms_us,interval_err_max_us,"
+               "cruise_jitter_us,cruise_std_us,cruise_velocity,cruise_vel_err_pct,max_step_jump_us\n");
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const SimCase_t* c = &s_cases[i];
+        SimResult_t r;
+
+        sim_run(c, &r);
+        if (json) {
+            printf("  {\"case\": %u, \"profile\": \"%s\", \"pipeline\": %u, \"max_speed\": %u, "
+                   "\"start_speed\": %u, \"accel\": %u, \"jerk\": %u, \"steps\": %u, "
+                   "\"steps_out\": %u, \"final_position\": %u, "
+                   "\"move_time_us\": %.0f, \"ideal_time_us\": %.0f, \"time_err_pct\": %.3f, "
+                   "\"peak_velocity\": %.1f, \"ideal_peak_velocity\": %.1f, "
+                   "\"accel_meas\": %.1f, \"accel_ideal\": %.1f, \"accel_err_pct\": %.3f, "
+                   "\"interval_err_rms_us\": %.3f, \"interval_err_max_us\": %.3f, "
+                   "\"cruise_jitter_us\": %.0f, \"cruise_std_us\": %.3f, "
+                   "\"cruise_velocity\": %.2f, \"cruise_vel_err_pct\": %.3f, \"max_step_jump_us\": %.0f}%s\n",
+                   (unsigned)i, s_profile_names[c->profile], c->pipeline, c->max_speed,
+                   c->start_speed, c->accel, c->jerk, c->steps, r.steps_out, r.final_position,
+                   r.move_time_us, r.ideal_time_us, pct(r.move_time_us, r.ideal_time_us),
+                   r.peak_velocity, r.ideal_peak_velocity,
+                   r.accel_meas, r.accel_ideal, pct(r.accel_meas, r.accel_ideal),
+                   r.interval_err_rms_us, r.interval_err_max_us,
+                   r.cruise_jitter_us, r.cruise_std_us,
+                   r.cruise_velocity, r.cruise_velocity ? pct(r.cruise_velocity, r.ideal_peak_velocity) : 0,
+                   r.max_step_jump_us,
+                   (i + 1 < count) ? "," : "");
+        } else {
+            printf("%u,%s,%u,%u,%u,%u,%u,%u,%u,%u,%.0f,%.0f,%.3f,%.1f,%.1f,%.1f,%.1f,%.3f,"
+                   "%.3f,%.3f,%.0f,%.3f,%.2f,%.3f,%.0f\n",
+                   (unsigned)i, s_profile_names[c->profile], c->pipeline, c->max_speed,
+                   c->start_speed, c->accel, c->jerk, c->steps, r.steps_out, r.final_position,
+                   r.move_time_us, r.ideal_time_us, pct(r.move_time_us, r.ideal_time_us),
+                   r.peak_velocity, r.ideal_peak_velocity,
+                   r.accel_meas, r.accel_ideal, pct(r.accel_meas, r.accel_ideal),
+                   r.interval_err_rms_us, r.interval_err_max_us,
+                   r.cruise_jitter_us, r.cruise_std_us,
+                   r.cruise_velocity, r.cruise_velocity ? pct(r.cruise_velocity, r.ideal_peak_velocity) : 0,
+                   r.max_step_jump_us);
+        }
+    }
+
+    if (json) {
+        printf("]\n");
+    }
+    return 0;
+}
@@ -0,0 +1,111 @@
+/**
+ * @file py32f0xx_hal.h
+ * @brief 主机仿真用的HAL桩头文件
+ * @note 只提供 BSP 电机相关代码用到的类型、寄存器和函数，外设寄存器是普通内存，
+ *       由仿真程序读写来模拟硬件行为
+ */
+
+#ifndef __PY32F0XX_HAL_STUB_H
+#define __PY32F0XX_HAL_STUB_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+#define __IO volatile
+
+typedef enum {
+    HAL_OK = 0,
+    HAL_ERROR = 1
+} HAL_StatusTypeDef;
+
+typedef struct {
+    __IO uint32_t CR1;
+    __IO uint32_t CR2;
+    __IO uint32_t SMCR;
+    __IO uint32_t DIER;
+    __IO uint32_t SR;
+    __IO uint32_t EGR;
+    __IO uint32_t CCMR1;
+    __IO uint32_t CCMR2;
+    __IO uint32_t CCER;
+    __IO uint32_t CNT;
+    __IO uint32_t PSC;
+    __IO uint32_t ARR;
+    __IO uint32_t RCR;
+    __IO uint32_t CCR1;
+    __IO uint32_t CCR2;
+    __IO uint32_t CCR3;
+    __IO uint32_t CCR4;
+    __IO uint32_t BDTR;
+    __IO uint32_t DCR;
+    __IO uint32_t DMAR;
+    __IO uint32_t OR;
+} TIM_TypeDef;
+
+typedef struct {
+    uint32_t Prescaler;
+    uint32_t CounterMode;
+    uint32_t Period;
+    uint32_t ClockDivision;
+    uint32_t RepetitionCounter;
+    uint32_t AutoReloadPreload;
+} TIM_Base_InitTypeDef;
+
+typedef struct {
+    TIM_TypeDef *Instance;
+    TIM_Base_InitTypeDef Init;
+} TIM_HandleTypeDef;
+
+typedef struct {
+    __IO uint32_t MODER;
+    __IO uint32_t OTYPER;
+    __IO uint32_t OSPEEDR;
+    __IO uint32_t PUPDR;
+    __IO uint32_t IDR;
+    __IO uint32_t ODR;
+    __IO uint32_t BSRR;
+    __IO uint32_t LCKR;
+    __IO uint32_t AFR[2];
+    __IO uint32_t BRR;
+} GPIO_TypeDef;
+
+typedef enum {
+    TIM1_CC_IRQn = 14,
+    TIM3_IRQn = 16
+} IRQn_Type;
+
+extern TIM_TypeDef g_host_tim1;
+extern TIM_TypeDef g_host_tim3;
+#define TIM1 (&g_host_tim1)
+#define TIM3 (&g_host_tim3)
+
+extern GPIO_TypeDef g_host_gpioa;
+extern GPIO_TypeDef g_host_gpiob;
+#define GPIOA (&g_host_gpioa)
+#define GPIOB (&g_host_gpiob)
+
+#define TIM_IT_UPDATE                   0x0001U
+#define TIM_IT_CC1                      0x0002U
+#define TIM_IT_CC2                      0x0004U
+#define TIM_IT_CC3                      0x0008U
+#define TIM_IT_CC4                      0x0010U
+#define TIM_COUNTERMODE_UP              0x0000U
+#define TIM_AUTORELOAD_PRELOAD_ENABLE   0x0080U
+
+#define __HAL_RCC_TIM1_CLK_ENABLE()     do { } while (0)
+#define __HAL_RCC_TIM3_CLK_ENABLE()     do { } while (0)
+
+extern uint32_t SystemCoreClock;
+
+HAL_StatusTypeDef HAL_TIM_Base_Init(TIM_HandleTypeDef *htim);
+HAL_StatusTypeDef HAL_TIM_Base_Start(TIM_HandleTypeDef *htim);
+void HAL_NVIC_SetPriority(IRQn_Type IRQn, uint32_t PreemptPriority, uint32_t SubPriority);
+void HAL_NVIC_EnableIRQ(IRQn_Type IRQn);
+
+static inline uint32_t __get_PRIMASK(void) { return 0; }
+static inline void __set_PRIMASK(uint32_t priMask) { (void)priMask; }
+static inline void __disable_irq(void) { }
+static inline void __enable_irq(void) { }
+
+#endif /* __PY32F0XX_HAL_STUB_H */